@@ -17,6 +17,7 @@
 #include "types.h"
 #include "param.h"
 #include "spinlock.h"
+#include "slab.h"
 #include "sleeplock.h"
 #include "riscv.h"
 #include "defs.h"
@@ -25,7 +26,8 @@
 
 struct {
   struct spinlock lock;
-  struct buf buf[NBUF];
+  struct slabcache cache;
+  int n;                      // number of buffers
 
   // Linked list of all buffers, through prev/next.
   // Sorted by how recently the buffer was used.
@@ -33,23 +35,25 @@ struct {
   struct buf head;
 } bcache;
 
+static void
+bctor(void *obj)
+{
+  struct buf *b = obj;
+
+  initsleeplock(&b->lock, "buffer");
+  b->disk = 0;
+  b->wq.head = 0;
+}
+
 void
 binit(void)
 {
-  struct buf *b;
-
   initlock(&bcache.lock, "bcache");
+  slabinit(&bcache.cache, "buf", sizeof(struct buf), bctor);
 
-  // Create linked list of buffers
+  // Create empty linked list of buffers
   bcache.head.prev = &bcache.head;
   bcache.head.next = &bcache.head;
-  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
-    initsleeplock(&b->lock, "buffer");
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
-  }
 }
 
 // Look through buffer cache for block on device dev.
@@ -73,19 +77,31 @@ bget(uint dev, uint blockno)
   }
 
   // Not cached.
-  // Recycle the least recently used (LRU) unused buffer.
-  for(b = bcache.head.prev; b != &bcache.head; b = b->prev){
-    if(b->refcnt == 0) {
-      b->dev = dev;
-      b->blockno = blockno;
-      b->valid = 0;
-      b->refcnt = 1;
-      release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
+  // Once there are NBUF buffers, recycle the least recently
+  // used (LRU) unused buffer.  Otherwise, or if all are in
+  // use, allocate another.
+  if(bcache.n >= NBUF){
+    for(b = bcache.head.prev; b != &bcache.head; b = b->prev){
+      if(b->refcnt == 0)
+        goto found;
     }
   }
-  panic("bget: no buffers");
+  if((b = slaballoc(&bcache.cache)) == 0)
+    panic("bget: no buffers");
+  bcache.n++;
+  b->next = bcache.head.next;
+  b->prev = &bcache.head;
+  bcache.head.next->prev = b;
+  bcache.head.next = b;
+
+found:
+  b->dev = dev;
+  b->blockno = blockno;
+  b->valid = 0;
+  b->refcnt = 1;
+  release(&bcache.lock);
+  acquiresleep(&b->lock);
+  return b;
 }
 
 // Return a locked buf with the contents of the indicated block.
@@ -123,7 +139,14 @@ brelse(struct buf *b)
 
   acquire(&bcache.lock);
   b->refcnt--;
-  if (b->refcnt == 0) {
+  if (b->refcnt == 0 && bcache.n > NBUF) {
+    // no one is waiting for it, and the cache has grown
+    // past NBUF: free it.
+    b->next->prev = b->prev;
+    b->prev->next = b->next;
+    bcache.n--;
+    slabfree(&bcache.cache, b);
+  } else if (b->refcnt == 0) {
     // no one is waiting for it.
     b->next->prev = b->prev;
     b->prev->next = b->next;
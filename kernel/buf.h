@@ -1,6 +1,7 @@
 struct buf {
   int valid;   // has data been read from disk?
   int disk;    // does disk "own" buf?
+  struct waitq wq; // processes waiting for the disk to finish with buf
   uint dev;
   uint blockno;
   struct sleeplock lock;
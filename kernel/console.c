@@ -50,6 +50,7 @@ struct {
   uint r;  // Read index
   uint w;  // Write index
   uint e;  // Edit index
+  struct waitq rq; // consoleread() waiting for input
 } cons;
 
 //
@@ -93,7 +94,7 @@ consoleread(int user_dst, uint64 dst, int n)
         release(&cons.lock);
         return -1;
       }
-      sleep(&cons.r, &cons.lock);
+      sleep(&cons.rq, &cons.lock);
     }
 
     c = cons.buf[cons.r++ % INPUT_BUF];
@@ -169,7 +170,7 @@ consoleintr(int c)
         // wake up consoleread() if a whole line (or end-of-file)
         // has arrived.
         cons.w = cons.e;
-        wakeup(&cons.r);
+        wakeup(&cons.rq);
       }
     }
     break;
@@ -2,12 +2,17 @@ struct buf;
 struct context;
 struct file;
 struct inode;
+struct memstat;
 struct pipe;
 struct proc;
 struct spinlock;
 struct sleeplock;
+struct slabcache;
 struct stat;
+struct schedparam;
 struct superblock;
+struct timer;
+struct waitq;
 
 // bio.c
 void            binit(void);
@@ -63,6 +68,11 @@ void            ramdiskrw(struct buf*);
 void*           kalloc(void);
 void            kfree(void *);
 void            kinit(void);
+void*           kallocpages(int);
+void            kref(void *);
+int             krefcount(void *);
+void            kfreepages(void *, int);
+void            kmemstat(struct memstat*);
 
 // log.c
 void            initlog(int, struct superblock*);
@@ -71,6 +81,7 @@ void            begin_op(void);
 void            end_op(void);
 
 // pipe.c
+void            pipeinit(void);
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, uint64, int);
@@ -96,10 +107,10 @@ struct proc*    myproc();
 void            procinit(void);
 void            scheduler(void) __attribute__((noreturn));
 void            sched(void);
-void            sleep(void*, struct spinlock*);
+void            sleep(struct waitq*, struct spinlock*);
 void            userinit(void);
 int             wait(uint64);
-void            wakeup(void*);
+void            wakeup(struct waitq*);
 void            yield(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
@@ -107,11 +118,59 @@ void            procdump(void);
 void            trace(int mask);
 void            set_priority(int priority, int pid, int* old);
 void            setrtime(void);
-int             waitx(uint64 addr, int* rtime, int* wtime);
-void            setPQ();
+int             waitx(uint64 addr, int* rtime, int* wtime, uint64 ruaddr);
+int             getrusage(int, uint64);
 void            setwtime(void);
 void            chPQ(struct proc *p, int pqID);
 
+// sched.c
+extern int      schedpolicy;
+extern struct schedparam schedparam;
+int             dynprio(struct proc*);
+void            schedinit(void);
+void            schedclock(void);
+void            runqput(struct proc*);
+int             runqremove(struct proc*);
+struct proc*    runqget(struct cpu*);
+struct proc*    runqsteal(struct cpu*);
+void            schedidle(struct cpu*);
+void            resched(struct cpu*);
+int             reschedpending(void);
+int             idlestcpu(uint);
+int             wakecpu(struct proc*);
+void            latrecord(struct proc*, uint64);
+int             sched_getstats(uint64, int);
+void            schedtick(struct proc*);
+int             schedyield(struct proc*);
+void            schedexit(struct proc*);
+int             sched_setpolicy(int, int);
+int             sched_setdeadline(int, int, int, int);
+int             settickets(int, int);
+void            lendtickets(struct proc*, int);
+void            reclaimtickets(void);
+int             sched_setaffinity(int, int);
+int             sched_getaffinity(int);
+int             sched_getparams(uint64);
+int             sched_setparams(uint64);
+
+// timer.c
+void            timeradd(struct timer*, uint, void (*)(struct timer*));
+void            timerdel(struct timer*);
+void            timerwake(struct timer*);
+void            timerrun(void);
+uint            timernext(void);
+
+// schedtrace.c
+void            traceinit(void);
+void            traceevent(int, struct proc*, int);
+int             schedtrace(uint64, int);
+
+// slab.c
+void            slabinit(struct slabcache*, char*, uint, void (*)(void*));
+void*           slaballoc(struct slabcache*);
+void            slabfree(struct slabcache*, void*);
+int             slabreclaim(void);
+
 // swtch.S
 void            swtch(struct context*, struct context*);
 
@@ -151,6 +210,9 @@ extern uint     ticks;
 void            trapinit(void);
 void            trapinithart(void);
 extern struct spinlock tickslock;
+void            ipi(int);
+void            idlewait(uint);
+void            settickhz(int);
 void            usertrapret(void);
 
 // uart.c
@@ -170,6 +232,8 @@ void            uvminit(pagetable_t, uchar *, uint);
 uint64          uvmalloc(pagetable_t, uint64, uint64);
 uint64          uvmdealloc(pagetable_t, uint64, uint64);
 int             uvmcopy(pagetable_t, pagetable_t, uint64);
+int             uvmcow(pagetable_t, uint64);
+int             uvmlazy(pagetable_t, uint64, uint64);
 void            uvmfree(pagetable_t, uint64);
 void            uvmunmap(pagetable_t, uint64, uint64, int);
 void            uvmclear(pagetable_t, uint64);
@@ -15,6 +15,7 @@
 #include "param.h"
 #include "stat.h"
 #include "spinlock.h"
+#include "slab.h"
 #include "proc.h"
 #include "sleeplock.h"
 #include "fs.h"
@@ -163,9 +164,12 @@ bfree(int dev, uint b)
 // multi-step atomic operations.
 //
 // The itable.lock spin-lock protects the allocation of itable
-// entries. Since ip->ref indicates whether an entry is free,
-// and ip->dev and ip->inum indicate which i-node an entry
-// holds, one must hold itable.lock while using any of those fields.
+// entries, which come from a slab cache and are on the
+// itable.inodes list while ip->ref is positive.  Since
+// ip->ref indicates whether an entry is in use, and ip->dev
+// and ip->inum indicate which i-node an entry holds, one
+// must hold itable.lock while using any of those fields,
+// or ip->next and ip->prev.
 //
 // An ip->lock sleep-lock protects all ip-> fields other than ref,
 // dev, and inum.  One must hold ip->lock in order to
@@ -173,18 +177,23 @@ bfree(int dev, uint b)
 
 struct {
   struct spinlock lock;
-  struct inode inode[NINODE];
+  struct inode *inodes;       // entries in use
+  struct slabcache cache;
 } itable;
 
+static void
+ictor(void *obj)
+{
+  struct inode *ip = obj;
+
+  initsleeplock(&ip->lock, "inode");
+}
+
 void
 iinit()
 {
-  int i = 0;
-  
   initlock(&itable.lock, "itable");
-  for(i = 0; i < NINODE; i++) {
-    initsleeplock(&itable.inode[i].lock, "inode");
-  }
+  slabinit(&itable.cache, "inode", sizeof(struct inode), ictor);
 }
 
 static struct inode* iget(uint dev, uint inum);
@@ -242,31 +251,32 @@ iupdate(struct inode *ip)
 static struct inode*
 iget(uint dev, uint inum)
 {
-  struct inode *ip, *empty;
+  struct inode *ip;
 
   acquire(&itable.lock);
 
   // Is the inode already in the table?
-  empty = 0;
-  for(ip = &itable.inode[0]; ip < &itable.inode[NINODE]; ip++){
-    if(ip->ref > 0 && ip->dev == dev && ip->inum == inum){
+  for(ip = itable.inodes; ip; ip = ip->next){
+    if(ip->dev == dev && ip->inum == inum){
       ip->ref++;
       release(&itable.lock);
       return ip;
     }
-    if(empty == 0 && ip->ref == 0)    // Remember empty slot.
-      empty = ip;
   }
 
-  // Recycle an inode entry.
-  if(empty == 0)
+  // Allocate an inode entry.
+  if((ip = slaballoc(&itable.cache)) == 0)
     panic("iget: no inodes");
 
-  ip = empty;
   ip->dev = dev;
   ip->inum = inum;
   ip->ref = 1;
   ip->valid = 0;
+  ip->prev = 0;
+  ip->next = itable.inodes;
+  if(ip->next)
+    ip->next->prev = ip;
+  itable.inodes = ip;
   release(&itable.lock);
 
   return ip;
@@ -353,7 +363,16 @@ iput(struct inode *ip)
     acquire(&itable.lock);
   }
 
-  ip->ref--;
+  if(--ip->ref == 0){
+    // free the entry.
+    if(ip->prev)
+      ip->prev->next = ip->next;
+    else
+      itable.inodes = ip->next;
+    if(ip->next)
+      ip->next->prev = ip->prev;
+    slabfree(&itable.cache, ip);
+  }
   release(&itable.lock);
 }
 
@@ -1,12 +1,34 @@
 // Physical memory allocator, for user processes,
 // kernel stacks, page-table pages,
-// and pipe buffers. Allocates whole 4096-byte pages.
+// and pipe buffers. Allocates whole 4096-byte pages,
+// or physically contiguous runs of 2^order pages.
+//
+// The global pool kmem is a binary buddy allocator: a
+// free block of 2^k pages starts at a multiple of 2^k
+// pages, its buddy is the other half of the block of
+// 2^(k+1) pages that contains it, and freeing a block
+// whose buddy is free too merges them.  kmem.order[]
+// records, for each page, whether it starts a free block
+// and of what order, which is all merging needs to know.
+//
+// Every page handed out by kalloc() or kallocpages() has a
+// reference count, so that copy-on-write fork can share it:
+// kref() adds a reference, and kfree() drops one, only
+// freeing the page once the last is gone.  kfreepages()
+// drops the one reference of each page in a block.
+//
+// Each cpu keeps a cache of free pages, so most kalloc()
+// and kfree() calls only take that cpu's own, uncontended,
+// lock.  A cache is refilled from, and drained to, kmem
+// PCPBATCH pages at a time; a cpu that finds kmem empty
+// too steals from the other caches.
 
 #include "types.h"
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
 #include "riscv.h"
+#include "memstat.h"
 #include "defs.h"
 
 void freerange(void *pa_start, void *pa_end);
@@ -14,29 +36,123 @@ void freerange(void *pa_start, void *pa_end);
 extern char end[]; // first address after kernel.
                    // defined by kernel.ld.
 
+// a free page or block; prev is only used in kmem.
 struct run {
   struct run *next;
+  struct run *prev;
 };
 
+#define PCPMAX   64   // most pages a cpu's cache holds
+#define PCPBATCH 16   // pages moved to or from kmem at a time
+
+#define NPAGE    ((PHYSTOP - KERNBASE) / PGSIZE)
+#define PAGENO(pa) (((uint64)(pa) - KERNBASE) / PGSIZE)
+#define PAGEPA(i)  ((struct run *)(KERNBASE + (uint64)(i) * PGSIZE))
+
 struct {
   struct spinlock lock;
-  struct run *freelist;
+  struct run *free[MAXORDER];   // free blocks of each order
+  int nfree[MAXORDER];
+  uchar order[NPAGE];           // 1 + order of the free block a page starts, or 0
+  int npage;                    // pages managed
 } kmem;
 
+struct pcp {
+  struct spinlock lock;
+  struct run *freelist;
+  int n;
+} pcp[NCPU];
+
+// references to each page from kalloc(), updated atomically.
+static int pageref[NPAGE];
+
 void
 kinit()
 {
   initlock(&kmem.lock, "kmem");
+  for(int i = 0; i < NCPU; i++)
+    initlock(&pcp[i].lock, "pcp");
   freerange(end, (void*)PHYSTOP);
 }
 
+static void
+blockpush(struct run *r, int order)
+{
+  r->prev = 0;
+  r->next = kmem.free[order];
+  if(r->next)
+    r->next->prev = r;
+  kmem.free[order] = r;
+  kmem.nfree[order]++;
+  kmem.order[PAGENO(r)] = order + 1;
+}
+
+static void
+blockremove(struct run *r, int order)
+{
+  if(r->prev)
+    r->prev->next = r->next;
+  else
+    kmem.free[order] = r->next;
+  if(r->next)
+    r->next->prev = r->prev;
+  kmem.nfree[order]--;
+  kmem.order[PAGENO(r)] = 0;
+}
+
+// Free the block of 2^order pages at r to kmem, merging
+// it with its buddy for as long as that is free too.
+// Caller must hold kmem.lock.
+static void
+buddyput(struct run *r, int order)
+{
+  uint64 i = PAGENO(r), b;
+
+  for(; order < MAXORDER - 1; order++){
+    b = i ^ (1 << order);
+    if(b >= NPAGE || kmem.order[b] != order + 1)
+      break;
+    blockremove(PAGEPA(b), order);
+    i &= ~(uint64)(1 << order);
+  }
+  blockpush(PAGEPA(i), order);
+}
+
+// Take a block of 2^order pages from kmem, splitting a
+// larger one if need be, or return 0 if there is none.
+// Caller must hold kmem.lock.
+static struct run*
+buddyget(int order)
+{
+  struct run *r;
+  int k;
+
+  for(k = order; k < MAXORDER && kmem.free[k] == 0; k++)
+    ;
+  if(k == MAXORDER)
+    return 0;
+  r = kmem.free[k];
+  blockremove(r, k);
+  // give back the upper halves.
+  while(k > order){
+    k--;
+    blockpush(PAGEPA(PAGENO(r) + (1 << k)), k);
+  }
+  return r;
+}
+
 void
 freerange(void *pa_start, void *pa_end)
 {
   char *p;
   p = (char*)PGROUNDUP((uint64)pa_start);
-  for(; p + PGSIZE <= (char*)pa_end; p += PGSIZE)
-    kfree(p);
+  for(; p + PGSIZE <= (char*)pa_end; p += PGSIZE){
+    memset(p, 1, PGSIZE);
+    acquire(&kmem.lock);
+    buddyput((struct run*)p, 0);
+    kmem.npage++;
+    release(&kmem.lock);
+  }
 }
 
 // Free the page of physical memory pointed at by v,
@@ -47,21 +163,85 @@ void
 kfree(void *pa)
 {
   struct run *r;
+  struct pcp *c;
 
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("kfree");
 
+  r = (struct run*)pa;
+  switch(__sync_sub_and_fetch(&pageref[PAGENO(r)], 1)){
+  case 0:
+    break;
+  case -1:
+    panic("kfree: not allocated");
+  default:
+    // still shared.
+    return;
+  }
+
   // Fill with junk to catch dangling refs.
   memset(pa, 1, PGSIZE);
 
-  r = (struct run*)pa;
+  push_off();
+  c = &pcp[cpuid()];
+  acquire(&c->lock);
+  r->next = c->freelist;
+  c->freelist = r;
+  if(++c->n > PCPMAX){
+    // give a batch back for other cpus.
+    acquire(&kmem.lock);
+    for(int i = 0; i < PCPBATCH; i++){
+      r = c->freelist;
+      c->freelist = r->next;
+      buddyput(r, 0);
+    }
+    release(&kmem.lock);
+    c->n -= PCPBATCH;
+  }
+  release(&c->lock);
+  pop_off();
+}
+
+// Move up to PCPBATCH pages from kmem to c, which the
+// caller has locked.
+static void
+refill(struct pcp *c)
+{
+  struct run *r;
 
   acquire(&kmem.lock);
-  r->next = kmem.freelist;
-  kmem.freelist = r;
+  while(c->n < PCPBATCH && (r = buddyget(0)) != 0){
+    r->next = c->freelist;
+    c->freelist = r;
+    c->n++;
+  }
   release(&kmem.lock);
 }
 
+// Take a page from another cpu's cache, or return 0 if
+// every cache is empty.  Only one cache is locked at a
+// time, so that stealing cpus cannot deadlock.
+static struct run*
+steal(struct pcp *self)
+{
+  struct pcp *c;
+  struct run *r;
+
+  for(c = pcp; c < &pcp[NCPU]; c++){
+    if(c == self)
+      continue;
+    acquire(&c->lock);
+    if((r = c->freelist) != 0){
+      c->freelist = r->next;
+      c->n--;
+    }
+    release(&c->lock);
+    if(r)
+      return r;
+  }
+  return 0;
+}
+
 // Allocate one 4096-byte page of physical memory.
 // Returns a pointer that the kernel can use.
 // Returns 0 if the memory cannot be allocated.
@@ -69,14 +249,110 @@ void *
 kalloc(void)
 {
   struct run *r;
+  struct pcp *c;
 
+  push_off();
+  c = &pcp[cpuid()];
+  acquire(&c->lock);
+  if(c->freelist == 0)
+    refill(c);
+  if((r = c->freelist) != 0){
+    c->freelist = r->next;
+    c->n--;
+  }
+  release(&c->lock);
+  if(r == 0)
+    r = steal(c);
+  pop_off();
+  // slab caches may be holding empty pages.
+  if(r == 0 && slabreclaim() > 0)
+    return kalloc();
+
+  if(r){
+    pageref[PAGENO(r)] = 1;
+    memset((char*)r, 5, PGSIZE); // fill with junk
+  }
+  return (void*)r;
+}
+
+// Add a reference to pa, a page from kalloc().
+void
+kref(void *pa)
+{
+  if(__sync_fetch_and_add(&pageref[PAGENO(pa)], 1) < 1)
+    panic("kref");
+}
+
+// Number of references to pa, a page from kalloc().
+int
+krefcount(void *pa)
+{
+  return __atomic_load_n(&pageref[PAGENO(pa)], __ATOMIC_RELAXED);
+}
+
+// Allocate 2^order physically contiguous pages, starting
+// at a multiple of 2^order pages.  Returns 0 if there is
+// no free block that large.  Pages in the per-cpu caches
+// are not merged back to make one.
+void *
+kallocpages(int order)
+{
+  struct run *r;
+
+  if(order < 0 || order >= MAXORDER)
+    return 0;
+  if(order == 0)
+    return kalloc();
   acquire(&kmem.lock);
-  r = kmem.freelist;
-  if(r)
-    kmem.freelist = r->next;
+  r = buddyget(order);
   release(&kmem.lock);
 
-  if(r)
-    memset((char*)r, 5, PGSIZE); // fill with junk
+  if(r){
+    for(int i = 0; i < (1 << order); i++)
+      pageref[PAGENO(r) + i] = 1;
+    memset((char*)r, 5, PGSIZE << order); // fill with junk
+  }
   return (void*)r;
 }
+
+// Free 2^order pages allocated by kallocpages(order), or
+// any aligned part of such a block.  Each page must have
+// just the one reference kallocpages() gave it.
+void
+kfreepages(void *pa, int order)
+{
+  if(order < 0 || order >= MAXORDER || ((uint64)pa - KERNBASE) % (PGSIZE << order) != 0 ||
+     (char*)pa < end || (uint64)pa + (PGSIZE << order) > PHYSTOP)
+    panic("kfreepages");
+  if(order == 0){
+    kfree(pa);
+    return;
+  }
+  for(int i = 0; i < (1 << order); i++){
+    if(__sync_sub_and_fetch(&pageref[PAGENO(pa) + i], 1) != 0)
+      panic("kfreepages: shared or not allocated");
+  }
+
+  // Fill with junk to catch dangling refs.
+  memset(pa, 1, PGSIZE << order);
+
+  acquire(&kmem.lock);
+  buddyput((struct run*)pa, order);
+  release(&kmem.lock);
+}
+
+// Fill in ms with the allocator's free memory counts.
+void
+kmemstat(struct memstat *ms)
+{
+  int i;
+
+  memset(ms, 0, sizeof(*ms));
+  acquire(&kmem.lock);
+  for(i = 0; i < MAXORDER; i++)
+    ms->nfree[i] = kmem.nfree[i];
+  ms->npage = kmem.npage;
+  release(&kmem.lock);
+  for(i = 0; i < NCPU; i++)
+    ms->cached += pcp[i].n;
+}
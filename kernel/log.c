@@ -45,6 +45,7 @@ struct log {
   int committing;  // in commit(), please wait.
   int dev;
   struct logheader lh;
+  struct waitq wq; // begin_op() waiting for a commit or log space.
 };
 struct log log;
 
@@ -129,10 +130,10 @@ begin_op(void)
   acquire(&log.lock);
   while(1){
     if(log.committing){
-      sleep(&log, &log.lock);
+      sleep(&log.wq, &log.lock);
     } else if(log.lh.n + (log.outstanding+1)*MAXOPBLOCKS > LOGSIZE){
       // this op might exhaust log space; wait for commit.
-      sleep(&log, &log.lock);
+      sleep(&log.wq, &log.lock);
     } else {
       log.outstanding += 1;
       release(&log.lock);
@@ -159,7 +160,7 @@ end_op(void)
     // begin_op() may be waiting for log space,
     // and decrementing log.outstanding has decreased
     // the amount of reserved space.
-    wakeup(&log);
+    wakeup(&log.wq);
   }
   release(&log.lock);
 
@@ -169,7 +170,7 @@ end_op(void)
     commit();
     acquire(&log.lock);
     log.committing = 0;
-    wakeup(&log);
+    wakeup(&log.wq);
     release(&log.lock);
   }
 }
@@ -0,0 +1,8 @@
+// Physical memory allocator statistics, for memstat().
+#define MAXORDER 11     // kallocpages() hands out blocks of up to 2^(MAXORDER-1) pages
+
+struct memstat {
+  int nfree[MAXORDER];  // free blocks of 2^i pages in the buddy allocator
+  int cached;           // free pages in the per-cpu caches
+  int npage;            // pages managed in all
+};
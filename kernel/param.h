@@ -1,13 +1,19 @@
 #define NPROC        64  // maximum number of processes
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
-#define NFILE       100  // open files per system
-#define NINODE       50  // maximum number of active i-nodes
+#define NINODE       50  // only for usertests' iref test; inodes come from a slab cache
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
-#define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
+#define NBUF         (MAXOPBLOCKS*3)  // buffers the disk block cache keeps
 #define FSSIZE       1000  // size of file system in blocks
 #define MAXPATH      128   // maximum file path name
+#define MAXQ         5     // SCHED_MLFQ priority levels
+#ifndef HZ
+#define HZ           10    // clock ticks per second at boot; make HZ=n
+#endif
+#ifndef QUANTUM
+#define QUANTUM      1     // round robin time slice at boot, in ticks; make QUANTUM=n
+#endif
@@ -3,6 +3,7 @@
 #include "defs.h"
 #include "param.h"
 #include "spinlock.h"
+#include "slab.h"
 #include "proc.h"
 #include "fs.h"
 #include "sleeplock.h"
@@ -17,8 +18,31 @@ struct pipe {
   uint nwrite;    // number of bytes written
   int readopen;   // read fd is still open
   int writeopen;  // write fd is still open
+  struct waitq rq;  // readers waiting for data
+  struct waitq wq;  // writers waiting for space
+  struct proc *reader;  // last process to read, and its pid,
+  int readerpid;        // for lendtickets()
+  struct proc *writer;  // last process to write, and its pid
+  int writerpid;
 };
 
+static struct slabcache pipecache;
+
+static void
+pipector(void *obj)
+{
+  struct pipe *pi = obj;
+
+  initlock(&pi->lock, "pipe");
+  pi->rq.head = pi->wq.head = 0;
+}
+
+void
+pipeinit(void)
+{
+  slabinit(&pipecache, "pipe", sizeof(struct pipe), pipector);
+}
+
 int
 pipealloc(struct file **f0, struct file **f1)
 {
@@ -28,13 +52,14 @@ pipealloc(struct file **f0, struct file **f1)
   *f0 = *f1 = 0;
   if((*f0 = filealloc()) == 0 || (*f1 = filealloc()) == 0)
     goto bad;
-  if((pi = (struct pipe*)kalloc()) == 0)
+  if((pi = slaballoc(&pipecache)) == 0)
     goto bad;
   pi->readopen = 1;
   pi->writeopen = 1;
   pi->nwrite = 0;
   pi->nread = 0;
-  initlock(&pi->lock, "pipe");
+  pi->reader = pi->writer = 0;
+  pi->readerpid = pi->writerpid = 0;
   (*f0)->type = FD_PIPE;
   (*f0)->readable = 1;
   (*f0)->writable = 0;
@@ -47,7 +72,7 @@ pipealloc(struct file **f0, struct file **f1)
 
  bad:
   if(pi)
-    kfree((char*)pi);
+    slabfree(&pipecache, pi);
   if(*f0)
     fileclose(*f0);
   if(*f1)
@@ -61,14 +86,14 @@ pipeclose(struct pipe *pi, int writable)
   acquire(&pi->lock);
   if(writable){
     pi->writeopen = 0;
-    wakeup(&pi->nread);
+    wakeup(&pi->rq);
   } else {
     pi->readopen = 0;
-    wakeup(&pi->nwrite);
+    wakeup(&pi->wq);
   }
   if(pi->readopen == 0 && pi->writeopen == 0){
     release(&pi->lock);
-    kfree((char*)pi);
+    slabfree(&pipecache, pi);
   } else
     release(&pi->lock);
 }
@@ -80,14 +105,19 @@ pipewrite(struct pipe *pi, uint64 addr, int n)
   struct proc *pr = myproc();
 
   acquire(&pi->lock);
+  pi->writer = pr;
+  pi->writerpid = pr->pid;
   while(i < n){
     if(pi->readopen == 0 || pr->killed){
       release(&pi->lock);
       return -1;
     }
     if(pi->nwrite == pi->nread + PIPESIZE){ //DOC: pipewrite-full
-      wakeup(&pi->nread);
-      sleep(&pi->nwrite, &pi->lock);
+      wakeup(&pi->rq);
+      // the reader we wait for gets our tickets meanwhile.
+      lendtickets(pi->reader, pi->readerpid);
+      sleep(&pi->wq, &pi->lock);
+      reclaimtickets();
     } else {
       char ch;
       if(copyin(pr->pagetable, &ch, addr + i, 1) == -1)
@@ -96,7 +126,7 @@ pipewrite(struct pipe *pi, uint64 addr, int n)
       i++;
     }
   }
-  wakeup(&pi->nread);
+  wakeup(&pi->rq);
   release(&pi->lock);
 
   return i;
@@ -110,12 +140,16 @@ piperead(struct pipe *pi, uint64 addr, int n)
   char ch;
 
   acquire(&pi->lock);
+  pi->reader = pr;
+  pi->readerpid = pr->pid;
   while(pi->nread == pi->nwrite && pi->writeopen){  //DOC: pipe-empty
     if(pr->killed){
       release(&pi->lock);
       return -1;
     }
-    sleep(&pi->nread, &pi->lock); //DOC: piperead-sleep
+    lendtickets(pi->writer, pi->writerpid);
+    sleep(&pi->rq, &pi->lock); //DOC: piperead-sleep
+    reclaimtickets();
   }
   for(i = 0; i < n; i++){  //DOC: piperead-copy
     if(pi->nread == pi->nwrite)
@@ -124,7 +158,7 @@ piperead(struct pipe *pi, uint64 addr, int n)
     if(copyout(pr->pagetable, addr + i, &ch, 1) == -1)
       break;
   }
-  wakeup(&pi->nwrite);  //DOC: piperead-wakeup
+  wakeup(&pi->wq);  //DOC: piperead-wakeup
   release(&pi->lock);
   return i;
 }
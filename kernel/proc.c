@@ -4,6 +4,9 @@
 #include "riscv.h"
 #include "spinlock.h"
 #include "proc.h"
+#include "sched.h"
+#include "rusage.h"
+#include "schedtrace.h"
 #include "defs.h"
 
 struct cpu cpus[NCPU];
@@ -12,8 +15,6 @@ struct proc proc[NPROC];
 
 struct proc *initproc;
 
-struct PrQ PQ[MAXQ];
-
 int nextpid = 1;
 struct spinlock pid_lock;
 
@@ -49,9 +50,12 @@ void
 procinit(void)
 {
   struct proc *p;
-  
+  struct cpu *c;
+
   initlock(&pid_lock, "nextpid");
   initlock(&wait_lock, "wait_lock");
+  for(c = cpus; c < &cpus[NCPU]; c++)
+      initlock(&c->runq.lock, "runq");
   for(p = proc; p < &proc[NPROC]; p++) {
       initlock(&p->lock, "proc");
       p->kstack = KSTACK((int) (p - proc));
@@ -99,86 +103,48 @@ allocpid() {
   return pid;
 }
 
-// Look in the process table for an UNUSED proc.
-// If found, initialize state required to run in the kernel,
-// and return with p->lock held.
-// If there are no free procs, or a memory allocation fails, return 0.
-
-
-
-void
-addprocPQ(struct PrQ *PQ, struct proc *element)
-{
-  PQ->proc[PQ->tail] = element;
-  PQ->tail++;
-  if (PQ->tail == NPROC + 1) {
-    PQ->tail = 0;
-  }
-  PQ->size++;
-}
-
-void
-popprocPQ(struct PrQ *PQ)
+// Mark p RUNNABLE and queue it on the runq of p->cpu,
+// the cpu it last ran on, or of a cpu running a process
+// p preempts; see wakecpu().
+// Caller must hold p->lock.
+static void
+setrunnable(struct proc *p)
 {
-  if (PQ->size == 0) 
-  {
-    panic("Queue is empty");
-  }
-  PQ->head = (PQ->head+1) % (NPROC+1);
-  PQ->size--;
-}
+  uint64 now = r_time();
 
-struct proc*
-getproc(struct PrQ *PQ)
-{
-  if (PQ->head == PQ->tail) 
-  {
-    return 0;
-  } 
-  return PQ->proc[PQ->head];
+  if(p->state == SLEEPING)
+    p->cyc_stime += now - p->stamp;
+  p->stamp = now;
+  p->state = RUNNABLE;
+  p->cpu = wakecpu(p);
+  p->cfsplace = 1;
+  runqput(p);
 }
 
-void 
-deleteprocPQ(struct PrQ *PQ, int pid) 
+// Account a clock tick to the process running on this
+// hart, if any.  Called from every hart's timer interrupt,
+// so that each hart only touches its own process.
+void setrtime()
 {
-  for (int curr = PQ->head; curr != PQ->tail; curr = (curr + 1) % (NPROC + 1)) 
+  struct proc* p = myproc();
+  if(p == 0)
   {
-    if (PQ->proc[curr]->pid == pid) 
-    {
-      struct proc *temp = PQ->proc[curr];
-      PQ->proc[curr] = PQ->proc[(curr + 1) % (NPROC + 1)];
-      PQ->proc[(curr + 1) % (NPROC + 1)] = temp;
-    } 
+    return;
   }
-  PQ->size--;
-  PQ->tail = PQ->tail - 1 < 0 ? NPROC : PQ->tail - 1;
-}
-
-void setrtime()
-{
-  struct proc* p;
-  for(p = proc; p < &proc[NPROC]; p++)
+  acquire(&p->lock);
+  if(p->state == RUNNING)
   {
-    if(!p)
-    {
-      continue;
-    }
-    acquire(&p->lock);
-    if(p->state == RUNNING)
-    {
-      p->total_rtime++;
-      #ifdef PBS
-      p->rtime++;
-      #endif
-      #ifdef MLFQ
-      p->timeslices--;
-      p->PQwtime[p->PQIndex]++;
-      #endif
-    }
-    release(&p->lock);
+    p->total_rtime++;
+    p->rtime++;
+    schedtick(p);
   }
+  release(&p->lock);
 }
 
+// Look in the process table for an UNUSED proc.
+// If found, initialize state required to run in the kernel,
+// and return with p->lock held.
+// If there are no free procs, or a memory allocation fails, return 0.
 static struct proc*
 allocproc(void)
 {
@@ -197,15 +163,29 @@ allocproc(void)
 found:
   p->pid = allocpid();
   p->state = USED;
-  acquire(&tickslock);
+  p->cpu = cpuid();
+  p->policy = schedpolicy;
+  p->affinity = AFFINITY_ALL;
   p->ctime = ticks;
-  release(&tickslock);
   p->static_priority = 60;
   p->niceness = 5;
+  p->rtime = 0;
+  p->priority = dynprio(p);
   p->nrun = 0;
+  p->sched_end = 0;
+  p->stamp = p->cyc_ctime = r_time();
+  p->cyc_rtime = p->cyc_wtime = p->cyc_stime = 0;
+  p->nvcsw = p->nivcsw = 0;
+  p->nmigrate = 0;
+  p->hotmigrate = 0;
   p->tickstorage[0] = 0;
-  p->ifqueue = 0;
   p->PQIndex = 0;
+  p->vruntime = 0;
+  p->cfsplace = 0;
+  p->tickets = STRIDETICKETS;
+  p->borrowed = 0;
+  p->pass = 0;
+  p->lentto = 0;
   p->total_rtime = 0;
   p->tickstorage[1] = 0;
   p->Qticks = ticks;
@@ -255,10 +235,9 @@ freeproc(struct proc *p)
   p->pid = 0;
   p->parent = 0;
   p->name[0] = 0;
-  p->chan = 0;
+  p->wq = 0;
   p->killed = 0;
   p->xstate = 0;
-  p->ifqueue = 0;
   p->state = UNUSED;
 }
 
@@ -338,7 +317,7 @@ userinit(void)
   safestrcpy(p->name, "initcode", sizeof(p->name));
   p->cwd = namei("/");
 
-  p->state = RUNNABLE;
+  setrunnable(p);
 
   release(&p->lock);
 }
@@ -348,14 +327,16 @@ userinit(void)
 int
 growproc(int n)
 {
-  uint sz;
+  uint64 sz;
   struct proc *p = myproc();
 
   sz = p->sz;
   if(n > 0){
-    if((sz = uvmalloc(p->pagetable, sz, sz + n)) == 0) {
+    // only reserve the memory: usertrap() and copyin()
+    // and copyout() allocate each page on first touch.
+    if(sz + n > TRAPFRAME)
       return -1;
-    }
+    sz += n;
   } else if(n < 0){
     sz = uvmdealloc(p->pagetable, sz, sz + n);
   }
@@ -388,6 +369,12 @@ fork(void)
   //copy mask from parent to child 
   np->mask = p->mask;
 
+  // the child runs under its parent's scheduling policy,
+  // except that real-time reservations are not inherited.
+  np->policy = p->policy == SCHED_EDF ? schedpolicy : p->policy;
+  np->tickets = p->tickets;
+  np->affinity = p->affinity;
+
   // copy saved user registers.
   *(np->trapframe) = *(p->trapframe);
 
@@ -411,7 +398,9 @@ fork(void)
   release(&wait_lock);
 
   acquire(&np->lock);
-  np->state = RUNNABLE;
+  np->cpu = idlestcpu(np->affinity);
+  setrunnable(np);
+  traceevent(SE_FORK, np, p->pid);
   release(&np->lock);
 
   return pid;
@@ -430,42 +419,16 @@ void set_priority(int priority, int pid, int* old)
       *old = p->static_priority;
       p->static_priority = priority;
       p->niceness = 5;
-      release(&p->lock);
-      if(*old < priority)
-      {
-        yield();
-      }
-    }
-  }
-}
-
-void setprio()
-{
-  struct proc *p;
-  // int old_priority;
-  int wtime;
-  int niceness;
-  for(p = proc; p < &proc[NPROC]; p++) 
-  {
-    if(p->pid != 0)
-    {
-      if(p->rtime == 0)
-      {
-        niceness = 5;
-      }
-      else
-      {
-        wtime = p->sched_end - p->sched_start - p->rtime;
-        // printf("wtime: %d rtime: %d schedstart: %d schedend: %d\n", wtime, p->rtime, p->sched_start, p->sched_end);
-        niceness = (wtime*10)/(p->rtime + wtime);
-      }
-      // printf("%d\n",p->niceness);
-      int temp2 = p->static_priority - niceness + 5;
-      int temp = temp2 > 100 ? 100 : temp2;
-      int dp = temp > 0 ? temp : 0;      
-      // printf("%d %d %d %d\n",p->rtime,p->wtime, p->priority, dp);
-      acquire(&p->lock);
-      p->priority = dp;
+      // the runq is ordered by priority, so a queued
+      // process has to be re-queued under its new one.
+      int queued = runqremove(p);
+      p->priority = dynprio(p);
+      if(queued)
+        runqput(p);
+      // a worse priority may let a waiting process
+      // preempt p, on whichever cpu p is running.
+      if(p->state == RUNNING && *old < priority)
+        resched(&cpus[p->cpu]);
       release(&p->lock);
     }
   }
@@ -488,7 +451,7 @@ reparent(struct proc *p)
   for(pp = proc; pp < &proc[NPROC]; pp++){
     if(pp->parent == p){
       pp->parent = initproc;
-      wakeup(initproc);
+      wakeup(&initproc->childq);
     }
   }
 }
@@ -524,11 +487,13 @@ exit(int status)
   reparent(p);
 
   // Parent might be sleeping in wait().
-  wakeup(p->parent);
+  wakeup(&p->parent->childq);
   
   acquire(&p->lock);
 
   p->xstate = status;
+  traceevent(SE_EXIT, p, status);
+  schedexit(p);
   p->state = ZOMBIE;
   p->etime = ticks;
 
@@ -545,20 +510,26 @@ int
 wait(uint64 addr)
 {
   struct proc *np;
-  int havekids, pid;
-  struct proc *p = myproc();
+  int havekids, pid, kidpid;
+  struct proc *p = myproc(), *kid;
 
   acquire(&wait_lock);
 
   for(;;){
     // Scan through table looking for exited children.
     havekids = 0;
+    kid = 0;
+    kidpid = 0;
     for(np = proc; np < &proc[NPROC]; np++){
       if(np->parent == p){
         // make sure the child isn't still in exit() or swtch().
         acquire(&np->lock);
 
         havekids = 1;
+        if(np->state != ZOMBIE && kid == 0){
+          kid = np;
+          kidpid = np->pid;
+        }
         if(np->state == ZOMBIE){
           // Found one.
           pid = np->pid;
@@ -584,35 +555,96 @@ wait(uint64 addr)
     }
     
     // Wait for a child to exit.
-    sleep(p, &wait_lock);  //DOC: wait-sleep
+    // lend our tickets to a child meanwhile.
+    lendtickets(kid, kidpid);
+    sleep(&p->childq, &wait_lock);  //DOC: wait-sleep
+    reclaimtickets();
+  }
+}
+
+// Fill in ru for p, counting the time since p's
+// last state change.  Caller must hold p->lock.
+static void
+getru(struct proc *p, struct rusage *ru)
+{
+  uint64 now = p->state == ZOMBIE ? p->cyc_etime : r_time();
+  uint64 r = p->cyc_rtime, w = p->cyc_wtime, s = p->cyc_stime;
+
+  if(p->state == RUNNING)
+    r += now - p->stamp;
+  else if(p->state == RUNNABLE)
+    w += now - p->stamp;
+  else if(p->state == SLEEPING)
+    s += now - p->stamp;
+  ru->rtime = r * MTIME_NS;
+  ru->wtime = w * MTIME_NS;
+  ru->stime = s * MTIME_NS;
+  ru->etime = (now - p->cyc_ctime) * MTIME_NS;
+  ru->nrun = p->nrun;
+  ru->nvcsw = p->nvcsw;
+  ru->nivcsw = p->nivcsw;
+}
+
+// Copy the resource usage of process pid, or of the
+// calling process if pid is 0, to user address addr.
+int
+getrusage(int pid, uint64 addr)
+{
+  struct proc *p;
+  struct rusage ru;
+
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->state != UNUSED && p->pid == pid){
+      getru(p, &ru);
+      release(&p->lock);
+      return copyout(myproc()->pagetable, addr, (char *)&ru, sizeof(ru));
+    }
+    release(&p->lock);
   }
+  return -1;
 }
 
+// Like wait(), but also return the child's run and wait
+// times in ticks, and, if ruaddr is not 0, copy its
+// resource usage to ruaddr.
 int
-waitx(uint64 addr, int* rtime, int* wtime)
+waitx(uint64 addr, int* rtime, int* wtime, uint64 ruaddr)
 {
+  struct rusage ru;
   struct proc *np;
-  int havekids, pid;
-  struct proc *p = myproc();
+  int havekids, pid, kidpid;
+  struct proc *p = myproc(), *kid;
 
   acquire(&wait_lock);
 
   for(;;){
     // Scan through table looking for exited children.
     havekids = 0;
+    kid = 0;
+    kidpid = 0;
     for(np = proc; np < &proc[NPROC]; np++){
       if(np->parent == p){
         // make sure the child isn't still in exit() or swtch().
         acquire(&np->lock);
 
         havekids = 1;
+        if(np->state != ZOMBIE && kid == 0){
+          kid = np;
+          kidpid = np->pid;
+        }
         if(np->state == ZOMBIE){
           // Found one.
           pid = np->pid;
           *rtime = np->total_rtime;
           *wtime = np->etime - np->ctime - np->total_rtime;
-          if(addr != 0 && copyout(p->pagetable, addr, (char *)&np->xstate,
-                                  sizeof(np->xstate)) < 0) {
+          getru(np, &ru);
+          if((addr != 0 && copyout(p->pagetable, addr, (char *)&np->xstate,
+                                   sizeof(np->xstate)) < 0) ||
+             (ruaddr != 0 && copyout(p->pagetable, ruaddr, (char *)&ru,
+                                     sizeof(ru)) < 0)) {
             release(&np->lock);
             release(&wait_lock);
             return -1;
@@ -633,71 +665,13 @@ waitx(uint64 addr, int* rtime, int* wtime)
     }
     
     // Wait for a child to exit.
-    sleep(p, &wait_lock);  //DOC: wait-sleep
-  }
-}
-
-void setPQ()
-{
-  for(int i = 0; i < MAXQ; i++)
-  {
-    PQ[i].head = 0;
-    PQ[i].tail = 0;
-    PQ[i].size = 0;
-  }
-}
-
-void ageing()
-{
-  struct proc *p;
-  for(p = proc; p < &proc[NPROC]; p++)
-  {
-    if (p->state == RUNNABLE && ticks - p->Qticks >= AGELIMIT) {
-      if (p->ifqueue) {
-        deleteprocPQ(&PQ[p->PQIndex], p->pid);
-        p->ifqueue = 0;
-      }
-      if (p->PQIndex != 0) {
-        p->PQIndex--;
-      }
-      p->Qticks = ticks;
-    }
-  }
-}
-#ifdef MLFQ
-void addnewprocs()
-{
-  for (struct proc *p = proc; p < &proc[NPROC]; p++) 
-  {
-    if (p->state == RUNNABLE && p->ifqueue == 0) 
-    {
-      addprocPQ(&PQ[p->PQIndex], p);
-      p->ifqueue = 1;
-    }
+    // lend our tickets to a child meanwhile.
+    lendtickets(kid, kidpid);
+    sleep(&p->childq, &wait_lock);  //DOC: wait-sleep
+    reclaimtickets();
   }
 }
 
-static struct proc*
-getminproc(void)
-{
-  for (int i = 0; i < MAXQ; i++) 
-  {
-    while (PQ[i].size) 
-    {
-      struct proc *p = getproc(&PQ[i]);
-      popprocPQ(&PQ[i]);
-      p->ifqueue = 0;
-      if (p->state == RUNNABLE) {
-        p->Qticks = ticks;
-        return p;
-      }
-    } 
-  }
-  return 0;
-}
-#endif
-
-
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
 // Scheduler never returns.  It loops, doing:
@@ -710,189 +684,75 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();  
+  uint64 now;
   c->proc = 0;
-  #ifdef DEFAULT  // default is to use round-robin
+  c->started = 1;
   for(;;){
     // Avoid deadlock by ensuring that devices can interrupt.
     intr_on();
 
-    for(p = proc; p < &proc[NPROC]; p++) {
-      acquire(&p->lock);
-      if(p->state == RUNNABLE) {
-        // Switch to chosen process.  It is the process's job
-        // to release its lock and then reacquire it
-        // before jumping back to us.
-        p->state = RUNNING;
-        c->proc = p;
-        swtch(&c->context, &p->context);
-
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-      }
-      release(&p->lock);
-    }
-  }
-  #endif
-
-  #ifdef FCFS
-  for(;;)
-  {
-    // struct proc *alottedP = 0;
-    intr_on();
-    struct proc *minproc = 0;
-
-    //finding proc that was made earliest - sorting by ctime
-    for(p = proc; p < &proc[NPROC]; p++) 
-    {
-      if(p->state == RUNNABLE) 
-      {
-        if(!minproc)
-        {
-          minproc = p;
-        }
-        // printf("runningpid: %d\n",p->pid);
-        else if(p->ctime < minproc->ctime)
-        {
-          minproc = p;
-        }
-      }
-    }
-    // in case there are no runnable processes in ptable
-    if(!minproc)
-    {
-      continue;
-    }
-    //context switching for minproc
-    acquire(&minproc->lock);
-    if(minproc->state == RUNNABLE) 
-    {
-      minproc->state = RUNNING;
-      c->proc = minproc;
-      swtch(&c->context, &minproc->context);
-      c->proc = 0;
-    }
-    release(&minproc->lock);
-  }
-  #endif
-  
-  #ifdef PBS
-  // PBS scheduler
-  for(;;)
-  {
-    intr_on();
-    setprio();
-    struct proc *minproc = 0;
-    int min_priority = 101;
-    int sameprio = -1;
-    int samesched = -1;
-    for(p = proc; p < &proc[NPROC]; p++) 
-    {
-      if(p->state == RUNNABLE) 
-      {
-        if(p->priority < min_priority)
-        {
-          sameprio = 0;
-          min_priority = p->priority;
-          minproc = p;
-        }
-        else if(p->priority == min_priority)
-        {
-          sameprio++;
-        }
-      }
-    }
-    // incase no process in ptable is runnable
-    if(!minproc)
-    {
+    // Only this cpu's runq is examined, so the cost of
+    // a pass does not grow with NPROC or the number of
+    // cpus; an idle cpu steals from a busy sibling, or
+    // else waits for an interrupt.
+    if((p = runqget(c)) == 0)
+      p = runqsteal(c);
+    if(p == 0){
+      schedidle(c);
       continue;
     }
-    if(sameprio > 0)
-    {
-      // if there are multiple processes with same priority,
-      // then we will choose one that has been scheduled more
-      for(p = proc; p < &proc[NPROC]; p++) 
-      {
-        if(p->state == RUNNABLE) 
-        {
-          if(p->priority == min_priority)
-          {
-            //nrun is the number of time proc has been scheduled
-            if(p->nrun > minproc->nrun)
-            {
-              samesched = 0;
-              minproc = p;
-            }
-            else if(p->nrun == minproc->nrun)
-            {
-              samesched++;
-            }
-          }
-        }
-      }
-    }
-    if(samesched > 0)
-    {
-      // if there are multiple processes with same priority and same nrun,
-      // then we will choose one that has lower ctime
-      for(p = proc; p < &proc[NPROC]; p++) 
-      {
-        if(p->state == RUNNABLE) 
-        {
-          if(p->priority == min_priority && p->nrun == minproc->nrun)
-          {
-            if(p->ctime < minproc->ctime)
-            {
-              minproc = p;
-            }
-          }
-        }
-      }
-    }
-    acquire(&minproc->lock);
-    if(minproc->state == RUNNABLE) 
-    {
-      minproc->state = RUNNING;
-    minproc->sched_start = ticks;
-      minproc->nrun++;
-      c->proc = minproc;
-      minproc->rtime = 0;
-      // minproc->wtime = 0;
-      swtch(&c->context, &minproc->context);
-      minproc->sched_end = ticks;
-      c->proc = 0;
-    }
-    release(&minproc->lock);
-  }
-
-  #endif
-
-  #ifdef MLFQ
-
-  // MLFQ scheduler
 
-  for(;;)
-  {
-    intr_on();
-    ageing();
-    addnewprocs();
-    p  = getminproc();
-
-    if (p) {
-      acquire(&p->lock);
-      p->timeslices = 1 << p->PQIndex;
-      c->proc = p;
+    acquire(&p->lock);
+    if(p->state == RUNNABLE) {
+      // Switch to chosen process.  It is the process's job
+      // to release its lock and then reacquire it
+      // before jumping back to us.
+      now = r_time();
+      latrecord(p, now - p->stamp);
+      p->cyc_wtime += now - p->stamp;
+      p->stamp = now;
       p->state = RUNNING;
-      p->Qticks = ticks;
+      p->cpu = c - cpus;
+      traceevent(SE_SWITCHIN, p, p->lastcpu);
+      if(p->nrun > 0 && p->lastcpu != p->cpu){
+        p->nmigrate++;
+        if(ticks - p->sched_end < schedparam.cachehot)
+          p->hotmigrate++;
+      }
+      p->lastcpu = p->cpu;
       p->nrun++;
+      p->sched_start = ticks;
+      p->rtime = 0;
+      p->timeslices = schedparam.mlfqquanta[p->PQIndex];
+      p->Qticks = ticks;
+      // a request to preempt the previous process
+      // is answered by this choice.
+      c->resched = 0;
+      c->proc = p;
       swtch(&c->context, &p->context);
+
+      // Process is done running for now.
+      // It should have changed its p->state before coming back.
       c->proc = 0;
-      p->Qticks = ticks;
-      release(&p->lock);
+      now = r_time();
+      p->cyc_rtime += now - p->stamp;
+      p->stamp = now;
+      if(p->state == SLEEPING)
+        p->nvcsw++;
+      else if(p->state == RUNNABLE)
+        p->nivcsw++;
+      else if(p->state == ZOMBIE)
+        p->cyc_etime = now;
+      p->sched_end = ticks;
+      p->priority = dynprio(p);
+
+      // A process that yielded goes back on its runq,
+      // now that it is no longer running on this stack.
+      if(p->state == RUNNABLE)
+        runqput(p);
     }
+    release(&p->lock);
   }
-  
-  #endif 
 }
 
 // Switch to scheduler.  Must hold only p->lock
@@ -917,6 +777,8 @@ sched(void)
   if(intr_get())
     panic("sched interruptible");
 
+  traceevent(SE_SWITCHOUT, p, p->state == SLEEPING ? SR_SLEEP :
+             p->state == ZOMBIE ? SR_EXIT : SR_PREEMPT);
   intena = mycpu()->intena;
   swtch(&p->context, &mycpu()->context);
   mycpu()->intena = intena;
@@ -931,6 +793,7 @@ yield(void)
   #ifdef PBS
   // p->sched_end = ticks;
   #endif
+  // scheduler() puts p back on its runq.
   p->state = RUNNABLE;
   sched();
   release(&p->lock);
@@ -957,24 +820,46 @@ forkret(void)
   usertrapret();
 }
 
-// Atomically release lock and sleep on chan.
+// Take p off the waitq it is on.
+// Caller must hold the waitq's lock.
+static void
+wqremove(struct proc *p)
+{
+  if(p->wqprev)
+    p->wqprev->wqnext = p->wqnext;
+  else
+    p->wq->head = p->wqnext;
+  if(p->wqnext)
+    p->wqnext->wqprev = p->wqprev;
+  p->wq = 0;
+}
+
+// Atomically release lock and sleep on wq.
 // Reacquires lock when awakened.
+// lk must be the lock that protects wq.
 void
-sleep(void *chan, struct spinlock *lk)
+sleep(struct waitq *wq, struct spinlock *lk)
 {
   struct proc *p = myproc();
   
+  // Join wq while holding lk, which wakeup(wq)'s
+  // caller must hold too.
   // Must acquire p->lock in order to
   // change p->state and then call sched.
   // Once we hold p->lock, we can be
   // guaranteed that we won't miss any wakeup
   // (wakeup locks p->lock),
   // so it's okay to release lk.
+  p->wq = wq;
+  p->wqprev = 0;
+  p->wqnext = wq->head;
+  if(wq->head)
+    wq->head->wqprev = p;
+  wq->head = p;
 
   acquire(&p->lock);  //DOC: sleeplock1
   release(lk);
   // Go to sleep.
-  p->chan = chan;
   p->state = SLEEPING;
   // #ifdef PBS
   // p->tickstorage[0] = ticks;
@@ -983,36 +868,33 @@ sleep(void *chan, struct spinlock *lk)
   // printf("%d: sleep %d %d\n", p->pid, p->rtime,p->wtime);
   sched();
 
-  // Tidy up.
-  p->chan = 0;
-
   // Reacquire original lock.
   release(&p->lock);
   acquire(lk);
+
+  // Tidy up.  wakeup() takes the processes it wakes
+  // off wq, but kill() leaves its victim there.
+  if(p->wq)
+    wqremove(p);
 }
 
-// Wake up all processes sleeping on chan.
-// Must be called without any p->lock.
+// Wake up all processes sleeping on wq.
+// Must be called with the lock that protects wq,
+// and without any p->lock.
 void
-wakeup(void *chan)
+wakeup(struct waitq *wq)
 {
   struct proc *p;
 
-  for(p = proc; p < &proc[NPROC]; p++) {
-    if(p != myproc()){
-      acquire(&p->lock);
-      if(p->state == SLEEPING && p->chan == chan) {
-          #ifdef PBS
-          // p->sched_end = ticks;
-          #endif
-        p->state = RUNNABLE;
-        // #ifdef PBS
-        // p->tickstorage[1] = ticks;
-        // p->wtime += p->tickstorage[1] - p->tickstorage[0];
-        // #endif
-      }
-      release(&p->lock);
+  while((p = wq->head) != 0){
+    wqremove(p);
+    acquire(&p->lock);
+    // p may be awake already if it was killed.
+    if(p->state == SLEEPING){
+      setrunnable(p);
+      traceevent(SE_WAKEUP, p, p->cpu);
     }
+    release(&p->lock);
   }
 }
 
@@ -1033,7 +915,7 @@ kill(int pid)
           #ifdef PBS
           // p->sched_end = ticks;
           #endif
-        p->state = RUNNABLE;
+        setrunnable(p);
       }
       release(&p->lock);
       return 0;
@@ -1097,19 +979,26 @@ procdump(void)
       state = states[p->state];
     else
       state = "???";
-    #ifdef DEFAULT
-    printf("%d %s %s", p->pid, state, p->name);
-    #endif
-    #ifdef FCFS
-    printf("%d %s %s", p->pid, state, p->name);
-    #endif
-    #ifdef PBS
-    setprio();
-    printf("%d %d %s %d %d %d", p->pid, p->priority, state, p->total_rtime, ticks - p->ctime - p->total_rtime, p->nrun);
-    #endif
-    #ifdef MLFQ
-    printf("%d %d %s %d %d %d %d %d %d %d %d", p->pid, p->PQIndex, state, p->total_rtime, ticks - p->Qticks, p->nrun, p->PQwtime[0], p->PQwtime[1], p->PQwtime[2], p->PQwtime[3], p->PQwtime[4]);
-    #endif
-    printf("\n");
+    switch(p->policy){
+    case SCHED_PBS:
+      printf("%d %d %s %d %d %d %d %d", p->pid, p->priority, state, p->total_rtime, ticks - p->ctime - p->total_rtime, p->nrun, p->nmigrate, p->hotmigrate);
+      break;
+    case SCHED_MLFQ:
+      printf("%d %d %s %d %d %d %d %d %d %d %d %d %d", p->pid, p->PQIndex, state, p->total_rtime, ticks - p->Qticks, p->nrun, p->nmigrate, p->hotmigrate, p->PQwtime[0], p->PQwtime[1], p->PQwtime[2], p->PQwtime[3], p->PQwtime[4]);
+      break;
+    case SCHED_CFS:
+      printf("%d %d %s %d %d %d %d %d", p->pid, p->static_priority, state, p->total_rtime, (int)(p->vruntime >> 10), p->nrun, p->nmigrate, p->hotmigrate);
+      break;
+    case SCHED_EDF:
+      printf("%d %d/%d/%d %s %d %d %d %d %d %d", p->pid, p->dl_runtime, p->dl_deadline, p->dl_period, state, p->total_rtime, p->dl_left, p->dl_abs, p->nrun, p->nmigrate, p->hotmigrate);
+      break;
+    case SCHED_STRIDE:
+      printf("%d %d+%d %s %d %d %d %d %d", p->pid, p->tickets, p->borrowed, state, p->total_rtime, (int)(p->pass >> 10), p->nrun, p->nmigrate, p->hotmigrate);
+      break;
+    default:
+      printf("%d %s %s %d %d %d", p->pid, state, p->name, p->nrun, p->nmigrate, p->hotmigrate);
+      break;
+    }
+    printf(" %s\n", schedclasses[p->policy].name);
   }
 }
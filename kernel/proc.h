@@ -18,12 +18,58 @@ struct context {
   uint64 s11;
 };
 
+// FIFO of processes, linked through p->rqnext and p->rqprev.
+struct procq {
+  struct proc *head;
+  struct proc *tail;
+};
+
+// Binary min-heap of processes; p->rqidx is p's index in p[].
+struct procheap {
+  struct proc *p[NPROC];
+  int n;
+};
+
+// Red-black tree of processes, linked through p->rbleft,
+// p->rbright and p->rbparent.
+struct proctree {
+  struct proc *root;
+  struct proc *min;           // Leftmost process, or 0 if empty.
+};
+
+// Per-CPU queues of RUNNABLE processes, one per scheduling
+// policy (see sched.c).
+struct runq {
+  struct spinlock lock;
+  struct procq rr;            // SCHED_DEFAULT, in arrival order.
+  struct procheap fcfs;       // SCHED_FCFS, by creation time.
+  struct procheap pbs;        // SCHED_PBS, by dynamic priority.
+  struct procq mlfq[MAXQ];    // SCHED_MLFQ, one FIFO per level.
+  uint mlfqmask;              // Bit i is set iff mlfq[i] is non-empty.
+  struct proctree cfs;        // SCHED_CFS, by virtual runtime.
+  uint64 cfsmin;              // Monotonic lower bound on cfs vruntimes.
+  struct proctree edf;        // SCHED_EDF, by absolute deadline.
+  struct procheap edfwait;    // SCHED_EDF out of budget, by dl_release.
+  struct proctree stride;     // SCHED_STRIDE, by pass.
+  uint64 stridepass;          // Monotonic lower bound on stride passes.
+  int n;                      // Number of queued processes.
+  int load;                   // Sum of their rqweight.
+  int lastbalance;            // ticks at the last balance().
+  int balancefail;            // balance() passes that only found cache-hot processes.
+};
+
 // Per-CPU state.
 struct cpu {
   struct proc *proc;          // The process running on this cpu, or null.
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  struct runq runq;           // RUNNABLE processes waiting for this cpu.
+  int started;                // Has this cpu entered scheduler()?
+  int idle;                   // Is it in schedidle(), with nothing to run?
+  int tickless;               // Has it stopped its timer in idlewait()?
+  uint tickgen;               // tickgen its timer was last aligned to; see tickalign().
+  int resched;                // Should proc yield at its next trap? See resched().
 };
 
 extern struct cpu cpus[NCPU];
@@ -82,20 +128,19 @@ struct trapframe {
 
 enum procstate { UNUSED, USED, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
-#define MAXPROC 65
-#define MAXQ 5
-#define AGELIMIT 128
-
 // Per-process state
 struct proc {
   struct spinlock lock;
 
   // p->lock must be held when using these:
   enum procstate state;        // Process state
-  void *chan;                  // If non-zero, sleeping on chan
+  struct waitq *wq;            // If non-zero, sleeping on wq
   int killed;                  // If non-zero, have been killed
   int xstate;                  // Exit status to be returned to parent's wait
   int pid;                     // Process ID
+  int cpu;                     // cpu whose runq p joins when RUNNABLE
+  int policy;                  // scheduling policy, SCHED_* in sched.h
+  uint affinity;               // cpus p may run on, bit i for cpu i
 
   int mask;                    // its bits specify which syscalls to trace
   int ctime;                   // process creation time
@@ -103,10 +148,23 @@ struct proc {
   int wtime;                  // process waiting time
   int etime;                  // process exit time
   int nrun;              // number of times proc has been scheduled
+  int lastcpu;           // cpu proc last ran on
+  int nmigrate;          // number of times proc has run on a different cpu than last time
+  int hotmigrate;        // number of those within cachehot ticks of last running
   int sched_start;       // time when proc was scheduled
   int sched_end;         // time when proc was un-scheduled
   int total_rtime;       // total running time
 
+  // in mtime cycles, from rdtime:
+  uint64 stamp;                // time of the last state change
+  uint64 cyc_ctime;            // creation time
+  uint64 cyc_etime;            // exit time
+  uint64 cyc_rtime;            // time RUNNING
+  uint64 cyc_wtime;            // time RUNNABLE
+  uint64 cyc_stime;            // time SLEEPING
+  int nvcsw;                   // number of times p switched away to sleep
+  int nivcsw;                  // number of times p was preempted
+
   int static_priority;         // static priority
   int priority;                // dynamic priority
   int niceness;                // scheduling niceness
@@ -116,12 +174,47 @@ struct proc {
   int PQwtime[MAXQ];              
   int PQIndex;                 // index of the priority queue it belongs to
   int timeslices;              // number of timeslice left
-  int ifqueue;
-  int Qticks;             
+  int Qticks;                  // time p joined, or was last run at, its level
   // #endif
 
-  // wait_lock must be held when using this:
+  uint64 vruntime;             // CFS weighted run time, 1024 per tick at nice 0
+  int cfsplace;                // place vruntime near the runq's cfsmin when next queued
+
+  int dl_runtime;              // EDF budget per period, in ticks
+  int dl_period;               // EDF period, in ticks
+  int dl_deadline;             // EDF deadline, relative to the start of a period
+  int dl_util;                 // EDF dl_runtime/dl_period, scaled by 1024
+  int dl_abs;                  // EDF absolute deadline of the current period
+  int dl_left;                 // EDF budget left in the current period
+  int dl_release;              // EDF start of the next period
+  int dl_throttled;            // EDF budget used up, waiting for dl_release
+
+  int tickets;                 // stride share of the CPU
+  int borrowed;                // stride tickets lent to p by blocked processes
+  uint64 pass;                 // stride virtual time, STRIDE1/tickets per tick
+  struct proc *lentto;         // process p's tickets are lent to while p blocks
+  int lentpid;                 // pid of lentto when lent
+  int lent;                    // number of tickets lent
+
+  // the runq lock of p->cpu must be held when using these,
+  // and when changing PQIndex or Qticks of a queued process:
+  struct proc *rqnext;         // next process in the same runq FIFO
+  struct proc *rqprev;         // previous process in the same runq FIFO
+  int rqidx;                   // index of p in its runq heap
+  struct proc *rbleft;         // children and parent in its runq tree
+  struct proc *rbright;
+  struct proc *rbparent;
+  int rbred;                   // colour in its runq tree
+  int onrq;                    // non-zero if p is on a runq
+  int rqweight;                // p's share of its runq's load
+
+  // the lock protecting p->wq must be held when using these:
+  struct proc *wqnext;         // next process on the same waitq
+  struct proc *wqprev;         // previous process on the same waitq
+
+  // wait_lock must be held when using these:
   struct proc *parent;         // Parent process
+  struct waitq childq;         // wait() sleeps here for a child to exit
 
   // these are private to the process, so p->lock need not be held.
   uint64 kstack;               // Virtual address of kernel stack
@@ -134,20 +227,16 @@ struct proc {
   char name[16];               // Process name (debugging)
 };
 
-// #ifdef MLFQ
-struct PrQ {
-  // struct spinlock lock;
-  struct proc *proc[MAXPROC];
-  int head;                    // points to the next process that will be scheduled in PQ
-  int tail;                    // points to the location where next proc will be added
-  int size;                    // size of the PrQ
+// A scheduling policy.  See sched.c.
+struct schedclass {
+  char *name;
+  void (*enqueue)(struct runq*, struct proc*);   // add RUNNABLE p to rq
+  void (*dequeue)(struct runq*, struct proc*);   // remove queued p from rq
+  struct proc* (*pick_next)(struct runq*);      // queued process to run next, or 0
+  void (*tick)(struct proc*);                    // p was RUNNING on a clock tick; may be 0
+  int (*yield)(struct proc*);                    // on a timer interrupt: should p yield?
+  void (*clock)(struct runq*);                   // every timer interrupt on rq's cpu; may be 0
+  int (*preempt)(struct proc*, struct proc*);    // should queued p displace RUNNING cur? may be 0
 };
 
-
-
-void            addprocPQ(struct PrQ *list, struct proc *element);
-void            popprocPQ(struct PrQ *list);
-struct proc*    getproc(struct PrQ *list);
-void            deleteprocPQ(struct PrQ *list, int pid);
-void            ageing(void);
-void            addnewprocs();
+extern struct schedclass schedclasses[];
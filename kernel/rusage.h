@@ -0,0 +1,11 @@
+// Resource usage of a process, for getrusage() and waitx().
+// Times are in nanoseconds.
+struct rusage {
+  uint64 rtime;     // running
+  uint64 wtime;     // runnable, waiting for a cpu
+  uint64 stime;     // sleeping
+  uint64 etime;     // since creation, until exit
+  int nrun;         // number of times scheduled
+  int nvcsw;        // switches away by sleeping
+  int nivcsw;       // switches away by being preempted
+};
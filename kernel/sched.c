@@ -0,0 +1,1653 @@
+// Scheduling policies.
+//
+// Every policy is compiled in as a struct schedclass, and
+// every process has one, p->policy.  Each cpu's runq keeps
+// a queue per policy; a class's enqueue, dequeue and
+// pick_next are called with that runq's lock held, and its
+// tick and yield with p->lock held, or on p's own cpu.
+// scheduler() tries the classes in schedorder[], the
+// real-time class first, and runs the first process one
+// of them picks.
+//
+// The SCHEDULER the kernel was built with only sets the
+// policy the system boots with; sched_setpolicy() changes
+// it for one process or for the whole system at run time.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "sched.h"
+#include "schedtrace.h"
+#include "defs.h"
+
+extern struct proc proc[NPROC];
+
+// policy given to processes that don't inherit one.
+#if defined(FCFS)
+int schedpolicy = SCHED_FCFS;
+#elif defined(PBS)
+int schedpolicy = SCHED_PBS;
+#elif defined(MLFQ)
+int schedpolicy = SCHED_MLFQ;
+#elif defined(STRIDE)
+int schedpolicy = SCHED_STRIDE;
+#else
+int schedpolicy = SCHED_DEFAULT;
+#endif
+
+// the order scheduler() tries the policies in.
+static int schedorder[NSCHED] = {
+  SCHED_EDF, SCHED_DEFAULT, SCHED_FCFS, SCHED_PBS, SCHED_MLFQ, SCHED_CFS,
+  SCHED_STRIDE,
+};
+
+// runqtake() maxweight that lets any process through.
+#define ANYWEIGHT 0x7fffffff
+
+static void balance(struct cpu*);
+static void kickidle(struct proc*);
+static void preemptcheck(struct proc*);
+
+// tunables; see sched_setparams().  A cpu's balance()
+// runs every balanceinterval ticks, and treats a process
+// that ran less than cachehot ticks ago as still having
+// its working set in that cpu's cache.
+struct schedparam schedparam = {
+  .hz = HZ,
+  .rrquantum = QUANTUM,
+  .mlfqquanta = { 1, 2, 4, 8, 16 },
+  .agelimit = 128,
+  .balanceinterval = 4,
+  .cachehot = 2,
+};
+
+// sum of dl_util over all SCHED_EDF processes.
+static struct spinlock edflock;
+static int edfutil;
+
+// per-cpu scheduling latency histograms, so that
+// recording needs no lock.
+static struct schedstat stats[NCPU];
+
+// Append p to the FIFO q.
+static void
+qpush(struct procq *q, struct proc *p)
+{
+  p->rqnext = 0;
+  p->rqprev = q->tail;
+  if(q->tail)
+    q->tail->rqnext = p;
+  else
+    q->head = p;
+  q->tail = p;
+}
+
+// Unlink p from the FIFO q.
+static void
+qremove(struct procq *q, struct proc *p)
+{
+  if(p->rqprev)
+    p->rqprev->rqnext = p->rqnext;
+  else
+    q->head = p->rqnext;
+  if(p->rqnext)
+    p->rqnext->rqprev = p->rqprev;
+  else
+    q->tail = p->rqprev;
+  p->rqnext = p->rqprev = 0;
+}
+
+static void
+heapset(struct procheap *h, int i, struct proc *p)
+{
+  h->p[i] = p;
+  p->rqidx = i;
+}
+
+// Move h->p[i] towards the root until its parent
+// should run before it.
+static void
+heapup(struct procheap *h, int i, int (*before)(struct proc*, struct proc*))
+{
+  struct proc *p = h->p[i];
+
+  while(i > 0 && before(p, h->p[(i-1)/2])){
+    heapset(h, i, h->p[(i-1)/2]);
+    i = (i-1)/2;
+  }
+  heapset(h, i, p);
+}
+
+// Move h->p[i] towards the leaves until it should
+// run before both of its children.
+static void
+heapdown(struct procheap *h, int i, int (*before)(struct proc*, struct proc*))
+{
+  struct proc *p = h->p[i];
+  int child;
+
+  while((child = 2*i + 1) < h->n){
+    if(child+1 < h->n && before(h->p[child+1], h->p[child]))
+      child++;
+    if(!before(h->p[child], p))
+      break;
+    heapset(h, i, h->p[child]);
+    i = child;
+  }
+  heapset(h, i, p);
+}
+
+static void
+heappush(struct procheap *h, struct proc *p, int (*before)(struct proc*, struct proc*))
+{
+  heapset(h, h->n, p);
+  h->n++;
+  heapup(h, h->n-1, before);
+}
+
+static void
+heapremove(struct procheap *h, struct proc *p, int (*before)(struct proc*, struct proc*))
+{
+  int i = p->rqidx;
+
+  h->n--;
+  if(i != h->n){
+    heapset(h, i, h->p[h->n]);
+    heapdown(h, i, before);
+    heapup(h, i, before);
+  }
+  h->p[h->n] = 0;
+}
+
+static void
+rotateleft(struct proctree *t, struct proc *x)
+{
+  struct proc *y = x->rbright;
+
+  x->rbright = y->rbleft;
+  if(y->rbleft)
+    y->rbleft->rbparent = x;
+  y->rbparent = x->rbparent;
+  if(x->rbparent == 0)
+    t->root = y;
+  else if(x == x->rbparent->rbleft)
+    x->rbparent->rbleft = y;
+  else
+    x->rbparent->rbright = y;
+  y->rbleft = x;
+  x->rbparent = y;
+}
+
+static void
+rotateright(struct proctree *t, struct proc *x)
+{
+  struct proc *y = x->rbleft;
+
+  x->rbleft = y->rbright;
+  if(y->rbright)
+    y->rbright->rbparent = x;
+  y->rbparent = x->rbparent;
+  if(x->rbparent == 0)
+    t->root = y;
+  else if(x == x->rbparent->rbright)
+    x->rbparent->rbright = y;
+  else
+    x->rbparent->rbleft = y;
+  y->rbright = x;
+  x->rbparent = y;
+}
+
+// Add p to the red-black tree t.  Processes that
+// compare equal go after those already in t.
+static void
+treeinsert(struct proctree *t, struct proc *p, int (*before)(struct proc*, struct proc*))
+{
+  struct proc *parent, *g, *u, **link;
+  int leftmost = 1;
+
+  parent = 0;
+  link = &t->root;
+  while(*link){
+    parent = *link;
+    if(before(p, parent)){
+      link = &parent->rbleft;
+    } else {
+      link = &parent->rbright;
+      leftmost = 0;
+    }
+  }
+  p->rbparent = parent;
+  p->rbleft = p->rbright = 0;
+  p->rbred = 1;
+  *link = p;
+  if(leftmost)
+    t->min = p;
+
+  // restore the red-black properties: p is red, so
+  // only a red parent is a problem.
+  while((parent = p->rbparent) != 0 && parent->rbred){
+    g = parent->rbparent;
+    if(parent == g->rbleft){
+      u = g->rbright;
+      if(u && u->rbred){
+        parent->rbred = u->rbred = 0;
+        g->rbred = 1;
+        p = g;
+        continue;
+      }
+      if(p == parent->rbright){
+        rotateleft(t, parent);
+        p = parent;
+        parent = p->rbparent;
+      }
+      parent->rbred = 0;
+      g->rbred = 1;
+      rotateright(t, g);
+    } else {
+      u = g->rbleft;
+      if(u && u->rbred){
+        parent->rbred = u->rbred = 0;
+        g->rbred = 1;
+        p = g;
+        continue;
+      }
+      if(p == parent->rbleft){
+        rotateright(t, parent);
+        p = parent;
+        parent = p->rbparent;
+      }
+      parent->rbred = 0;
+      g->rbred = 1;
+      rotateleft(t, g);
+    }
+  }
+  t->root->rbred = 0;
+}
+
+// Replace the subtree rooted at u with the one rooted at v.
+static void
+transplant(struct proctree *t, struct proc *u, struct proc *v)
+{
+  if(u->rbparent == 0)
+    t->root = v;
+  else if(u == u->rbparent->rbleft)
+    u->rbparent->rbleft = v;
+  else
+    u->rbparent->rbright = v;
+  if(v)
+    v->rbparent = u->rbparent;
+}
+
+static int
+isred(struct proc *p)
+{
+  return p != 0 && p->rbred;
+}
+
+// The process after p in t's order, or 0.
+static struct proc*
+treenext(struct proc *p)
+{
+  if(p->rbright){
+    for(p = p->rbright; p->rbleft; p = p->rbleft)
+      ;
+    return p;
+  }
+  while(p->rbparent && p == p->rbparent->rbright)
+    p = p->rbparent;
+  return p->rbparent;
+}
+
+// Remove p from the red-black tree t.
+static void
+treeremove(struct proctree *t, struct proc *p)
+{
+  struct proc *x, *xparent, *y, *w;
+  int red;
+
+  if(t->min == p)
+    t->min = treenext(p);
+
+  // unlink p, or its successor y if p has two children,
+  // remembering the colour of the node that was taken
+  // out of the tree and the subtree x that replaced it.
+  red = p->rbred;
+  if(p->rbleft == 0){
+    x = p->rbright;
+    xparent = p->rbparent;
+    transplant(t, p, x);
+  } else if(p->rbright == 0){
+    x = p->rbleft;
+    xparent = p->rbparent;
+    transplant(t, p, x);
+  } else {
+    for(y = p->rbright; y->rbleft; y = y->rbleft)
+      ;
+    red = y->rbred;
+    x = y->rbright;
+    if(y->rbparent == p){
+      xparent = y;
+    } else {
+      xparent = y->rbparent;
+      transplant(t, y, x);
+      y->rbright = p->rbright;
+      y->rbright->rbparent = y;
+    }
+    transplant(t, p, y);
+    y->rbleft = p->rbleft;
+    y->rbleft->rbparent = y;
+    y->rbred = p->rbred;
+  }
+  p->rbleft = p->rbright = p->rbparent = 0;
+  if(red)
+    return;
+
+  // a black node was removed: x carries an extra black.
+  while(x != t->root && !isred(x)){
+    if(x == xparent->rbleft){
+      w = xparent->rbright;
+      if(w->rbred){
+        w->rbred = 0;
+        xparent->rbred = 1;
+        rotateleft(t, xparent);
+        w = xparent->rbright;
+      }
+      if(!isred(w->rbleft) && !isred(w->rbright)){
+        w->rbred = 1;
+        x = xparent;
+        xparent = x->rbparent;
+      } else {
+        if(!isred(w->rbright)){
+          w->rbleft->rbred = 0;
+          w->rbred = 1;
+          rotateright(t, w);
+          w = xparent->rbright;
+        }
+        w->rbred = xparent->rbred;
+        xparent->rbred = 0;
+        w->rbright->rbred = 0;
+        rotateleft(t, xparent);
+        x = t->root;
+      }
+    } else {
+      w = xparent->rbleft;
+      if(w->rbred){
+        w->rbred = 0;
+        xparent->rbred = 1;
+        rotateright(t, xparent);
+        w = xparent->rbleft;
+      }
+      if(!isred(w->rbleft) && !isred(w->rbright)){
+        w->rbred = 1;
+        x = xparent;
+        xparent = x->rbparent;
+      } else {
+        if(!isred(w->rbleft)){
+          w->rbright->rbred = 0;
+          w->rbred = 1;
+          rotateleft(t, w);
+          w = xparent->rbleft;
+        }
+        w->rbred = xparent->rbred;
+        xparent->rbred = 0;
+        w->rbleft->rbred = 0;
+        rotateright(t, xparent);
+        x = t->root;
+      }
+    }
+  }
+  if(x)
+    x->rbred = 0;
+}
+
+//
+// Round robin: a FIFO, and give up the cpu on every tick.
+//
+
+static void
+rr_enqueue(struct runq *rq, struct proc *p)
+{
+  qpush(&rq->rr, p);
+}
+
+static void
+rr_dequeue(struct runq *rq, struct proc *p)
+{
+  qremove(&rq->rr, p);
+}
+
+static struct proc*
+rr_pick_next(struct runq *rq)
+{
+  return rq->rr.head;
+}
+
+static int
+rr_yield(struct proc *p)
+{
+  return p->rtime >= schedparam.rrquantum;
+}
+
+//
+// FCFS: the oldest process first, never preempted.
+//
+
+static int
+fcfs_before(struct proc *a, struct proc *b)
+{
+  return a->ctime < b->ctime;
+}
+
+static void
+fcfs_enqueue(struct runq *rq, struct proc *p)
+{
+  heappush(&rq->fcfs, p, fcfs_before);
+}
+
+static void
+fcfs_dequeue(struct runq *rq, struct proc *p)
+{
+  heapremove(&rq->fcfs, p, fcfs_before);
+}
+
+static struct proc*
+fcfs_pick_next(struct runq *rq)
+{
+  return rq->fcfs.n ? rq->fcfs.p[0] : 0;
+}
+
+static int
+fcfs_yield(struct proc *p)
+{
+  return 0;
+}
+
+//
+// PBS: the lowest dynamic priority first, preempted
+// only by a process of better priority.
+//
+
+// PBS dynamic priority of p, from its static priority
+// and the niceness of its last scheduling round.
+int
+dynprio(struct proc *p)
+{
+  int wtime;
+  int niceness;
+  if(p->rtime == 0)
+  {
+    niceness = 5;
+  }
+  else
+  {
+    wtime = p->sched_end - p->sched_start - p->rtime;
+    niceness = (wtime*10)/(p->rtime + wtime);
+  }
+  int temp2 = p->static_priority - niceness + 5;
+  int temp = temp2 > 100 ? 100 : temp2;
+  return temp > 0 ? temp : 0;
+}
+
+// lower dynamic priority first, then the process
+// scheduled more often, then the older one.
+static int
+pbs_before(struct proc *a, struct proc *b)
+{
+  if(a->priority != b->priority)
+    return a->priority < b->priority;
+  if(a->nrun != b->nrun)
+    return a->nrun > b->nrun;
+  return a->ctime < b->ctime;
+}
+
+static void
+pbs_enqueue(struct runq *rq, struct proc *p)
+{
+  heappush(&rq->pbs, p, pbs_before);
+}
+
+static void
+pbs_dequeue(struct runq *rq, struct proc *p)
+{
+  heapremove(&rq->pbs, p, pbs_before);
+}
+
+static struct proc*
+pbs_pick_next(struct runq *rq)
+{
+  return rq->pbs.n ? rq->pbs.p[0] : 0;
+}
+
+static int
+pbs_yield(struct proc *p)
+{
+  return 0;
+}
+
+// only a strictly better priority preempts, e.g.
+// after set_priority().
+static int
+pbs_preempt(struct proc *p, struct proc *cur)
+{
+  return p->priority < cur->priority;
+}
+
+//
+// MLFQ: a FIFO per level, with a bitmap of the non-empty
+// levels.  Each level is kept in Qticks order, which
+// mlfq_clock() relies on.
+//
+
+static void
+mlfq_enqueue(struct runq *rq, struct proc *p)
+{
+  p->Qticks = ticks;
+  qpush(&rq->mlfq[p->PQIndex], p);
+  rq->mlfqmask |= 1 << p->PQIndex;
+}
+
+static void
+mlfq_dequeue(struct runq *rq, struct proc *p)
+{
+  qremove(&rq->mlfq[p->PQIndex], p);
+  if(rq->mlfq[p->PQIndex].head == 0)
+    rq->mlfqmask &= ~(1 << p->PQIndex);
+}
+
+static struct proc*
+mlfq_pick_next(struct runq *rq)
+{
+  int q;
+
+  if(rq->mlfqmask == 0)
+    return 0;
+  // the head of the highest-priority non-empty level.
+  for(q = 0; (rq->mlfqmask & (1 << q)) == 0; q++)
+    ;
+  return rq->mlfq[q].head;
+}
+
+static void
+mlfq_tick(struct proc *p)
+{
+  p->timeslices--;
+  p->PQwtime[p->PQIndex]++;
+}
+
+// once p has used up its time slice, move it down
+// a level and give up the cpu.
+static int
+mlfq_yield(struct proc *p)
+{
+  if(p->timeslices > 0)
+    return 0;
+  if(p->PQIndex != MAXQ - 1){
+    p->PQIndex++;
+    traceevent(SE_DEMOTE, p, p->PQIndex - 1);
+  }
+  return 1;
+}
+
+// a process at a higher level preempts, e.g. an
+// interactive one back from I/O preempting a CPU hog.
+static int
+mlfq_preempt(struct proc *p, struct proc *cur)
+{
+  return p->PQIndex < cur->PQIndex;
+}
+
+// Ageing: move processes that have waited agelimit ticks
+// at their level up one level.  Each level is a FIFO kept
+// in Qticks order, i.e. in order of ageing deadline, so
+// only the heads need checking and a waiting process is
+// touched once per agelimit ticks.
+static void
+mlfq_clock(struct runq *rq)
+{
+  struct proc *p;
+
+  for(int q = 1; q < MAXQ; q++)
+  {
+    while((p = rq->mlfq[q].head) != 0 && ticks - p->Qticks >= schedparam.agelimit)
+    {
+      mlfq_dequeue(rq, p);
+      p->PQIndex--;
+      mlfq_enqueue(rq, p);
+      traceevent(SE_AGE, p, q);
+    }
+  }
+}
+
+//
+// CFS: run the process that has had the least CPU time,
+// weighted by its static priority, so that CPU time is
+// shared in proportion to weight.  Each runq keeps its
+// processes in a red-black tree by virtual runtime.
+//
+
+// bound, in vruntime units, on how far a process joining
+// a runq, on waking, forking or moving from another cpu,
+// may be from the runq's cfsmin: limits the credit a long
+// sleeper gets and the debt a migrating process brings
+// from a busier cpu.  A process requeued after running
+// keeps its vruntime, so that low weights stay fair.
+#define CFSLATENCY (4*1024)
+
+// weights of nice levels -20..19, as in Linux: each
+// level is worth about 10% of CPU time to its neighbour.
+static int cfsweights[40] = {
+  88761, 71755, 56483, 46273, 36291,
+  29154, 23254, 18705, 14949, 11916,
+   9548,  7620,  6100,  4904,  3906,
+   3121,  2501,  1991,  1586,  1277,
+   1024,   820,   655,   526,   423,
+    335,   272,   215,   172,   137,
+    110,    87,    70,    56,    45,
+     36,    29,    23,    18,    15,
+};
+
+// static_priority 60, the default, is nice 0; every
+// two points above or below is one nice level.
+static int
+cfsweight(struct proc *p)
+{
+  int nice = (p->static_priority - 60) / 2;
+
+  if(nice < -20)
+    nice = -20;
+  if(nice > 19)
+    nice = 19;
+  return cfsweights[nice + 20];
+}
+
+static int
+cfs_before(struct proc *a, struct proc *b)
+{
+  return a->vruntime < b->vruntime;
+}
+
+// p is joining rq: clamp its vruntime to within
+// CFSLATENCY of rq's cfsmin.  Caller must hold rq->lock.
+static void
+cfs_place(struct runq *rq, struct proc *p)
+{
+  if(p->vruntime + CFSLATENCY < rq->cfsmin)
+    p->vruntime = rq->cfsmin - CFSLATENCY;
+  else if(p->vruntime > rq->cfsmin + CFSLATENCY)
+    p->vruntime = rq->cfsmin + CFSLATENCY;
+}
+
+static void
+cfs_enqueue(struct runq *rq, struct proc *p)
+{
+  if(p->cfsplace){
+    cfs_place(rq, p);
+    p->cfsplace = 0;
+  }
+  treeinsert(&rq->cfs, p, cfs_before);
+  if(rq->cfs.min->vruntime > rq->cfsmin)
+    rq->cfsmin = rq->cfs.min->vruntime;
+}
+
+static void
+cfs_dequeue(struct runq *rq, struct proc *p)
+{
+  treeremove(&rq->cfs, p);
+  if(rq->cfs.min && rq->cfs.min->vruntime > rq->cfsmin)
+    rq->cfsmin = rq->cfs.min->vruntime;
+}
+
+static struct proc*
+cfs_pick_next(struct runq *rq)
+{
+  return rq->cfs.min;
+}
+
+static void
+cfs_tick(struct proc *p)
+{
+  p->vruntime += 1024 * 1024 / cfsweight(p);
+}
+
+// give up the cpu once another process on this cpu's
+// runq is owed more CPU time than p.  Reads the tree
+// without its lock; a stale answer only delays or
+// hastens a switch by a tick.
+static int
+cfs_yield(struct proc *p)
+{
+  struct proc *next = cpus[p->cpu].runq.cfs.min;
+
+  return next != 0 && next->vruntime < p->vruntime;
+}
+
+//
+// EDF: real-time processes, each with a budget of
+// dl_runtime ticks every dl_period ticks, to be used
+// within dl_deadline ticks of the start of the period.
+// The runnable process with the earliest absolute
+// deadline runs first, ahead of every other class.  A
+// process that uses up its budget is throttled, kept
+// off the tree until its next period starts, so that
+// an overrun cannot eat into other processes' time.
+// sched_setdeadline() admits a process only if the sum
+// of runtime/period stays within the number of cpus.
+//
+
+static int
+edf_before(struct proc *a, struct proc *b)
+{
+  return a->dl_abs < b->dl_abs;
+}
+
+static int
+edf_release_before(struct proc *a, struct proc *b)
+{
+  return a->dl_release < b->dl_release;
+}
+
+// start a new period for p at time now.
+static void
+edf_replenish(struct proc *p, int now)
+{
+  p->dl_abs = now + p->dl_deadline;
+  p->dl_left = p->dl_runtime;
+  p->dl_release = now + p->dl_period;
+}
+
+static void
+edf_enqueue(struct runq *rq, struct proc *p)
+{
+  if(p->dl_left <= 0 && ticks < p->dl_release){
+    p->dl_throttled = 1;
+    heappush(&rq->edfwait, p, edf_release_before);
+    return;
+  }
+  // out of budget in a finished period, or woken after
+  // its deadline: a new period starts now.
+  if(p->dl_left <= 0 || ticks >= p->dl_abs)
+    edf_replenish(p, ticks);
+  treeinsert(&rq->edf, p, edf_before);
+}
+
+static void
+edf_dequeue(struct runq *rq, struct proc *p)
+{
+  if(p->dl_throttled){
+    heapremove(&rq->edfwait, p, edf_release_before);
+    p->dl_throttled = 0;
+  } else {
+    treeremove(&rq->edf, p);
+  }
+}
+
+static struct proc*
+edf_pick_next(struct runq *rq)
+{
+  return rq->edf.min;
+}
+
+static void
+edf_tick(struct proc *p)
+{
+  p->dl_left--;
+}
+
+// give up the cpu on overrunning the budget, or when a
+// process with an earlier deadline is waiting.  Reads
+// the tree without its lock, as cfs_yield() does.
+static int
+edf_yield(struct proc *p)
+{
+  struct proc *next = cpus[p->cpu].runq.edf.min;
+
+  if(p->dl_left <= 0)
+    return 1;
+  return next != 0 && next->dl_abs < p->dl_abs;
+}
+
+// move throttled processes whose next period has
+// started back onto the tree.
+static void
+edf_clock(struct runq *rq)
+{
+  struct proc *p;
+
+  while(rq->edfwait.n > 0 && (p = rq->edfwait.p[0])->dl_release <= ticks){
+    heapremove(&rq->edfwait, p, edf_release_before);
+    p->dl_throttled = 0;
+    edf_replenish(p, ticks);
+    treeinsert(&rq->edf, p, edf_before);
+  }
+}
+
+//
+// Stride: each process gets CPU time in proportion to its
+// tickets.  Its pass advances by STRIDE1/tickets on every
+// tick it runs, and the lowest pass runs next, so over any
+// interval the shares are exact to within a tick.  Each
+// runq keeps its processes in a red-black tree by pass.
+// A process blocked on another one can lend it its
+// tickets for the duration; see lendtickets().
+//
+
+#define STRIDE1 (1 << 20)
+
+static int
+stride(struct proc *p)
+{
+  return STRIDE1 / (p->tickets + p->borrowed);
+}
+
+static int
+stride_before(struct proc *a, struct proc *b)
+{
+  return a->pass < b->pass;
+}
+
+// a process joining a runq starts no earlier than the
+// runq's stridepass, so that time spent blocked or on
+// another cpu earns no credit, and no later than one
+// stride after it.
+static void
+stride_enqueue(struct runq *rq, struct proc *p)
+{
+  if(p->pass < rq->stridepass)
+    p->pass = rq->stridepass;
+  else if(p->pass > rq->stridepass + stride(p))
+    p->pass = rq->stridepass + stride(p);
+  treeinsert(&rq->stride, p, stride_before);
+  if(rq->stride.min->pass > rq->stridepass)
+    rq->stridepass = rq->stride.min->pass;
+}
+
+static void
+stride_dequeue(struct runq *rq, struct proc *p)
+{
+  treeremove(&rq->stride, p);
+  if(rq->stride.min && rq->stride.min->pass > rq->stridepass)
+    rq->stridepass = rq->stride.min->pass;
+}
+
+static struct proc*
+stride_pick_next(struct runq *rq)
+{
+  return rq->stride.min;
+}
+
+static void
+stride_tick(struct proc *p)
+{
+  p->pass += stride(p);
+}
+
+// as cfs_yield(), by pass.
+static int
+stride_yield(struct proc *p)
+{
+  struct proc *next = cpus[p->cpu].runq.stride.min;
+
+  return next != 0 && next->pass < p->pass;
+}
+
+struct schedclass schedclasses[NSCHED] = {
+[SCHED_DEFAULT] { "default", rr_enqueue, rr_dequeue, rr_pick_next, 0, rr_yield, 0, 0 },
+[SCHED_FCFS]    { "fcfs", fcfs_enqueue, fcfs_dequeue, fcfs_pick_next, 0, fcfs_yield, 0, 0 },
+[SCHED_PBS]     { "pbs", pbs_enqueue, pbs_dequeue, pbs_pick_next, 0, pbs_yield, 0, pbs_preempt },
+[SCHED_MLFQ]    { "mlfq", mlfq_enqueue, mlfq_dequeue, mlfq_pick_next, mlfq_tick, mlfq_yield, mlfq_clock, mlfq_preempt },
+[SCHED_CFS]     { "cfs", cfs_enqueue, cfs_dequeue, cfs_pick_next, cfs_tick, cfs_yield, 0, 0 },
+[SCHED_EDF]     { "edf", edf_enqueue, edf_dequeue, edf_pick_next, edf_tick, edf_yield, edf_clock, 0 },
+[SCHED_STRIDE]  { "stride", stride_enqueue, stride_dequeue, stride_pick_next, stride_tick, stride_yield, 0, 0 },
+};
+
+void
+schedinit(void)
+{
+  initlock(&edflock, "edf");
+}
+
+// Called on every timer interrupt, on each hart, to let
+// the policies do their periodic work on this hart's runq.
+void
+schedclock(void)
+{
+  struct runq *rq = &mycpu()->runq;
+
+  acquire(&rq->lock);
+  for(int i = 0; i < NSCHED; i++){
+    if(schedclasses[i].clock)
+      schedclasses[i].clock(rq);
+  }
+  release(&rq->lock);
+
+  if(ticks - rq->lastbalance >= schedparam.balanceinterval){
+    rq->lastbalance = ticks;
+    balance(mycpu());
+  }
+}
+
+// p has just been queued: wake its cpu if that is idle in
+// wfi, or else an idle cpu that p may run on, to steal it.
+// Pairs with the check in schedidle().
+static void
+kickidle(struct proc *p)
+{
+  struct cpu *c;
+
+  __sync_synchronize();
+  if(cpus[p->cpu].idle){
+    if(p->cpu != cpuid())
+      ipi(p->cpu);
+    return;
+  }
+  for(c = cpus; c < &cpus[NCPU]; c++){
+    if(c->idle && c != mycpu() && (p->affinity & (1 << (c - cpus)))){
+      ipi(c - cpus);
+      return;
+    }
+  }
+}
+
+// Ask cpu c to switch away from its current process at
+// the next trap return, which an IPI makes immediate if c
+// is another cpu.  See reschedpending().
+void
+resched(struct cpu *c)
+{
+  c->resched = 1;
+  __sync_synchronize();
+  if(c != mycpu())
+    ipi(c - cpus);
+}
+
+// Called on the way out of a trap: has resched() asked
+// this cpu to switch processes?  Clears the request.
+int
+reschedpending(void)
+{
+  int r;
+
+  push_off();
+  r = __sync_lock_test_and_set(&mycpu()->resched, 0);
+  pop_off();
+  return r;
+}
+
+static void
+lathistadd(struct lathist *h, uint64 wait)
+{
+  int i;
+
+  for(i = 0; i < LATBUCKETS - 1 && (wait >> (i + 1)) != 0; i++)
+    ;
+  h->count[i]++;
+  h->n++;
+  if(wait > h->max)
+    h->max = wait;
+}
+
+// p is being switched in on this cpu after being RUNNABLE
+// for wait mtime cycles.  Interrupts must be disabled.
+void
+latrecord(struct proc *p, uint64 wait)
+{
+  struct schedstat *s = &stats[cpuid()];
+
+  lathistadd(&s->policy[p->policy], wait);
+  if(p->policy == SCHED_MLFQ)
+    lathistadd(&s->mlfq[p->PQIndex], wait);
+}
+
+// The sum over all cpus of histogram i of struct schedstat,
+// counting its lathists in order; clear them too if reset.
+// A cpu recording concurrently may lose a count to reset.
+static void
+latsum(int i, struct lathist *h, int reset)
+{
+  struct lathist *c;
+
+  memset(h, 0, sizeof(*h));
+  for(int id = 0; id < NCPU; id++){
+    c = (struct lathist *)&stats[id] + i;
+    for(int b = 0; b < LATBUCKETS; b++)
+      h->count[b] += c->count[b];
+    h->n += c->n;
+    if(c->max > h->max)
+      h->max = c->max;
+    if(reset)
+      memset(c, 0, sizeof(*c));
+  }
+}
+
+// Copy the scheduling latency histograms to user address
+// addr, then clear them if reset.
+int
+sched_getstats(uint64 addr, int reset)
+{
+  struct lathist h;
+  int n = sizeof(struct schedstat) / sizeof(struct lathist);
+
+  for(int i = 0; i < n; i++){
+    latsum(i, &h, reset);
+    if(copyout(myproc()->pagetable, addr + i * sizeof(h), (char *)&h, sizeof(h)) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+// Position of policy in schedorder[].
+static int
+schedrank(int policy)
+{
+  int i;
+
+  for(i = 0; schedorder[i] != policy; i++)
+    ;
+  return i;
+}
+
+// Should RUNNABLE p displace cur, the process running on
+// a cpu?  Yes if p's policy comes first in schedorder[],
+// or, in the same policy, if its preempt operation says
+// so.  cur is read without its lock, as schedyield() reads
+// the queues; a stale answer only costs a needless switch,
+// or delays one to the next tick.
+static int
+outranks(struct proc *p, struct proc *cur)
+{
+  struct schedclass *sc;
+
+  if(cur == 0 || cur == p)
+    return 0;
+  if(p->policy != cur->policy)
+    return schedrank(p->policy) < schedrank(cur->policy);
+  sc = &schedclasses[p->policy];
+  return sc->preempt && sc->preempt(p, cur);
+}
+
+// p has just been queued: preempt the process running on
+// p's cpu if p should run instead.
+static void
+preemptcheck(struct proc *p)
+{
+  struct cpu *c = &cpus[p->cpu];
+
+  if(!c->resched && outranks(p, c->proc))
+    resched(c);
+}
+
+// The cpu p, waking up or newly forked, should be queued
+// on: p->cpu, unless p would not preempt the process
+// running there but would preempt the one running on
+// another cpu in p->affinity.  Idle cpus are left to
+// kickidle().  Caller must hold p->lock.
+int
+wakecpu(struct proc *p)
+{
+  struct cpu *c;
+
+  if((p->affinity & (1 << p->cpu)) == 0 ||
+     cpus[p->cpu].proc == 0 || outranks(p, cpus[p->cpu].proc))
+    return p->cpu;
+  for(c = cpus; c < &cpus[NCPU]; c++){
+    if((p->affinity & (1 << (c - cpus))) && c->started && outranks(p, c->proc))
+      return c - cpus;
+  }
+  return p->cpu;
+}
+
+// Nothing to run on c: wait in wfi, with c's periodic
+// timer interrupt stopped, until an interrupt, such as an
+// IPI from kickidle(), says there may be.
+void
+schedidle(struct cpu *c)
+{
+  struct runq *rq = &c->runq;
+  uint wake = 0;
+
+  intr_off();
+  c->idle = 1;
+  __sync_synchronize();
+  // anything queued here since runqget(), other than
+  // throttled EDF processes, can run.  Other runqs are
+  // not rechecked: runqsteal() has just failed, and what
+  // it failed on, such as processes pinned to their cpu,
+  // would fail it again; kickidle() wakes c for anything
+  // queued there from now on.
+  if(rq->n > rq->edfwait.n)
+    goto out;
+  // c must wake to release throttled EDF processes.
+  acquire(&rq->lock);
+  if(rq->edfwait.n > 0)
+    wake = rq->edfwait.p[0]->dl_release;
+  release(&rq->lock);
+  idlewait(wake);
+out:
+  c->idle = 0;
+  __sync_synchronize();
+  // hart 0 has to tick while any hart may be busy.
+  if(c != cpus && cpus[0].tickless)
+    ipi(0);
+  intr_on();
+}
+
+// Add p to the runq of cpu p->cpu, or of the idlest
+// cpu in p->affinity if p may not run on p->cpu.
+// Caller must hold p->lock, and p must be RUNNABLE.
+void
+runqput(struct proc *p)
+{
+  struct runq *rq;
+
+  if((p->affinity & (1 << p->cpu)) == 0){
+    p->cpu = idlestcpu(p->affinity);
+    p->cfsplace = 1;
+  }
+  rq = &cpus[p->cpu].runq;
+
+  acquire(&rq->lock);
+  if(p->onrq)
+    panic("runqput");
+  schedclasses[p->policy].enqueue(rq, p);
+  p->onrq = 1;
+  p->rqweight = cfsweight(p);
+  rq->n++;
+  rq->load += p->rqweight;
+  release(&rq->lock);
+
+  kickidle(p);
+  preemptcheck(p);
+}
+
+// Take p off its runq if it is on one, and
+// return whether it was.
+// Caller must hold p->lock.
+int
+runqremove(struct proc *p)
+{
+  struct runq *rq = &cpus[p->cpu].runq;
+  int onrq;
+
+  acquire(&rq->lock);
+  if((onrq = p->onrq) != 0){
+    schedclasses[p->policy].dequeue(rq, p);
+    p->onrq = 0;
+    rq->n--;
+    rq->load -= p->rqweight;
+  }
+  release(&rq->lock);
+  return onrq;
+}
+
+// Remove and return the process that should run next
+// from rq, of those allowed to run on cpu c, weighing at
+// most maxweight, and, unless hotok, not cache-hot; or 0
+// if there is none.  Only the next process of each class
+// is considered, so a process that may not run on c can
+// hide others behind it; that only matters for stealing
+// and balancing, as a cpu's own runq holds only processes
+// allowed on it.
+static struct proc*
+runqtake(struct runq *rq, struct cpu *c, int maxweight, int hotok)
+{
+  struct proc *p;
+  uint bit = 1 << (c - cpus);
+
+  acquire(&rq->lock);
+  for(int i = 0; i < NSCHED && rq->n > 0; i++){
+    struct schedclass *sc = &schedclasses[schedorder[i]];
+    if((p = sc->pick_next(rq)) == 0 || (p->affinity & bit) == 0)
+      continue;
+    if(p->rqweight > maxweight || (!hotok && ticks - p->sched_end < schedparam.cachehot))
+      continue;
+    sc->dequeue(rq, p);
+    p->onrq = 0;
+    rq->n--;
+    rq->load -= p->rqweight;
+    release(&rq->lock);
+    return p;
+  }
+  release(&rq->lock);
+  return 0;
+}
+
+// Number of processes on rq that could run now, i.e.
+// other than throttled EDF ones.
+static int
+runnable(struct runq *rq)
+{
+  return rq->n - rq->edfwait.n;
+}
+
+// Take the next process from this cpu's own runq.
+struct proc*
+runqget(struct cpu *c)
+{
+  if(c->runq.n == 0)
+    return 0;
+  return runqtake(&c->runq, c, ANYWEIGHT, 1);
+}
+
+// This cpu's runq is empty: take a process from the
+// runq of the busiest other cpu, or, if it has none that
+// may run here, of the next busiest, and so on.  Throttled
+// EDF processes cannot run, so they do not count.  The
+// queue lengths are read without locks; they are only a
+// hint, and runqtake() rechecks.
+struct proc*
+runqsteal(struct cpu *c)
+{
+  struct cpu *victim, *v;
+  struct proc *p;
+  uint tried = 0;
+
+  for(;;){
+    victim = 0;
+    for(v = cpus; v < &cpus[NCPU]; v++){
+      if(v == c || (tried & (1 << (v - cpus))) || runnable(&v->runq) == 0)
+        continue;
+      if(victim == 0 || runnable(&v->runq) > runnable(&victim->runq))
+        victim = v;
+    }
+    if(victim == 0)
+      return 0;
+    if((p = runqtake(&victim->runq, c, ANYWEIGHT, 1)) != 0)
+      break;
+    tried |= 1 << (victim - cpus);
+  }
+  if(p->policy == SCHED_CFS){
+    // p runs here without being queued here.
+    acquire(&c->runq.lock);
+    cfs_place(&c->runq, p);
+    release(&c->runq.lock);
+  }
+  return p;
+}
+
+// Even out the load between this cpu, c, and the most
+// loaded other cpu by pulling processes from the latter
+// until moving one more would not help.  Processes that
+// are cache-hot on the other cpu are left there, unless
+// the last few balances found nothing else to move.
+// Called from the timer interrupt.  Reads the other
+// runqs' loads without locks, as a hint.
+static void
+balance(struct cpu *c)
+{
+  struct runq *rq = &c->runq;
+  struct cpu *busiest, *v;
+  struct proc *p;
+  int moved = 0;
+
+  busiest = 0;
+  for(v = cpus; v < &cpus[NCPU]; v++){
+    if(v != c && v->started && (busiest == 0 || v->runq.load > busiest->runq.load))
+      busiest = v;
+  }
+  if(busiest == 0)
+    return;
+  for(int i = 0; i < NPROC && busiest->runq.load > rq->load; i++){
+    // moving a process of weight w closes the gap by
+    // 2w, so w must be at most half the gap.
+    p = runqtake(&busiest->runq, c, (busiest->runq.load - rq->load) / 2,
+                 rq->balancefail >= 3);
+    if(p == 0)
+      break;
+    // p is off every runq, as if this cpu had picked
+    // it to run, so no one else will touch p->cpu.
+    acquire(&p->lock);
+    p->cpu = c - cpus;
+    p->cfsplace = 1;
+    runqput(p);
+    release(&p->lock);
+    moved++;
+  }
+  if(moved)
+    rq->balancefail = 0;
+  else if(busiest->runq.load - rq->load >= 2 * 1024)
+    rq->balancefail++;
+}
+
+// Return the started cpu in mask with the shortest runq,
+// preferring this one on ties.  If no cpu in mask has
+// started yet, return the lowest-numbered one in mask.
+// Interrupts must be disabled.
+int
+idlestcpu(uint mask)
+{
+  struct cpu *c, *best;
+
+  best = (mask & (1 << cpuid())) ? mycpu() : 0;
+  for(c = cpus; c < &cpus[NCPU]; c++){
+    if((mask & (1 << (c - cpus))) == 0 || !c->started)
+      continue;
+    if(best == 0 || c->runq.n < best->runq.n)
+      best = c;
+  }
+  if(best == 0){
+    for(best = cpus; best < &cpus[NCPU-1]; best++)
+      if(mask & (1 << (best - cpus)))
+        break;
+  }
+  return best - cpus;
+}
+
+// Account a clock tick to p, which is RUNNING.
+// Caller must hold p->lock.
+void
+schedtick(struct proc *p)
+{
+  struct schedclass *sc = &schedclasses[p->policy];
+
+  if(sc->tick)
+    sc->tick(p);
+}
+
+// Called on a timer interrupt in p, the current process:
+// should p give up the cpu?  Yes if a process of a class
+// that comes before p's in schedorder[] is waiting on
+// this cpu, and otherwise as p's class decides.  Reads
+// the queues without the runq lock; a stale answer only
+// delays or hastens a switch by a tick.
+int
+schedyield(struct proc *p)
+{
+  struct runq *rq = &cpus[p->cpu].runq;
+
+  // its affinity changed; runqput() will move it.
+  if((p->affinity & (1 << p->cpu)) == 0)
+    return 1;
+  for(int i = 0; i < NSCHED && schedorder[i] != p->policy; i++){
+    if(schedclasses[schedorder[i]].pick_next(rq))
+      return 1;
+  }
+  return schedclasses[p->policy].yield(p);
+}
+
+// Switch p to policy.  Caller must hold p->lock.
+static void
+setpolicy(struct proc *p, int policy)
+{
+  // a queued process has to move to the
+  // new policy's queue.
+  int queued = runqremove(p);
+  if(policy == SCHED_MLFQ && p->policy != SCHED_MLFQ)
+    p->PQIndex = 0;
+  if(p->policy == SCHED_EDF && policy != SCHED_EDF){
+    acquire(&edflock);
+    edfutil -= p->dl_util;
+    release(&edflock);
+    p->dl_util = 0;
+  }
+  if(policy == SCHED_CFS && p->policy != SCHED_CFS)
+    p->cfsplace = 1;
+  p->policy = policy;
+  if(queued)
+    runqput(p);
+}
+
+// p is exiting: give back whatever the policy
+// reserved for it.  Caller must hold p->lock.
+void
+schedexit(struct proc *p)
+{
+  if(p->policy == SCHED_EDF)
+    setpolicy(p, schedpolicy);
+}
+
+// Switch process pid to policy or, if pid is 0, every
+// process and the processes created from now on.
+// Returns the previous policy, or -1 if there is
+// no such policy or process.
+int
+sched_setpolicy(int policy, int pid)
+{
+  struct proc *p;
+  int old = -1;
+
+  // real-time processes need parameters;
+  // see sched_setdeadline().
+  if(policy < 0 || policy >= NSCHED || policy == SCHED_EDF)
+    return -1;
+  if(pid == 0){
+    old = schedpolicy;
+    schedpolicy = policy;
+  }
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    // a system-wide change leaves real-time processes be.
+    if(p->state != UNUSED && (pid == 0 ? p->policy != SCHED_EDF : p->pid == pid)){
+      if(pid != 0)
+        old = p->policy;
+      setpolicy(p, policy);
+    }
+    release(&p->lock);
+  }
+  return old;
+}
+
+// Make process pid, or the calling process if pid is 0,
+// a SCHED_EDF process that needs runtime ticks of CPU
+// time every period ticks, within deadline ticks of the
+// start of each period; or with runtime 0, return it to
+// the system's policy.  Fails, returning -1, if the
+// parameters make no sense or if admitting the process
+// would make the real-time processes' total utilization
+// more than the number of cpus.
+int
+sched_setdeadline(int runtime, int period, int deadline, int pid)
+{
+  struct proc *p;
+  struct cpu *c;
+  int util, ncpu, err;
+
+  if(runtime < 0 || (runtime > 0 && (deadline < runtime || period < deadline)))
+    return -1;
+  // round up, so that admission stays conservative; in
+  // uint64, as runtime * 1024 overflows an int.
+  util = runtime > 0 ? ((uint64)runtime * 1024 + period - 1) / period : 0;
+  ncpu = 0;
+  for(c = cpus; c < &cpus[NCPU]; c++)
+    if(c->started)
+      ncpu++;
+  if(pid == 0)
+    pid = myproc()->pid;
+
+  err = -1;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->state == UNUSED || p->state == ZOMBIE || p->pid != pid){
+      release(&p->lock);
+      continue;
+    }
+    if(runtime == 0){
+      if(p->policy == SCHED_EDF)
+        setpolicy(p, schedpolicy);
+      err = 0;
+    } else {
+      acquire(&edflock);
+      int old = p->policy == SCHED_EDF ? p->dl_util : 0;
+      if(edfutil - old + util <= ncpu * 1024){
+        edfutil += util - old;
+        err = 0;
+      }
+      release(&edflock);
+      if(err == 0){
+        int queued = runqremove(p);
+        p->dl_runtime = runtime;
+        p->dl_period = period;
+        p->dl_deadline = deadline;
+        p->dl_util = util;
+        p->dl_throttled = 0;
+        edf_replenish(p, ticks);
+        p->policy = SCHED_EDF;
+        if(queued)
+          runqput(p);
+      }
+    }
+    release(&p->lock);
+    break;
+  }
+  return err;
+}
+
+// Give process pid, or the calling process if pid is 0,
+// tickets tickets, its share of the CPU under SCHED_STRIDE.
+// Returns the old number, or -1.
+int
+settickets(int tickets, int pid)
+{
+  struct proc *p;
+  int old = -1;
+
+  if(tickets < 1 || tickets > STRIDEMAX)
+    return -1;
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->state != UNUSED && p->pid == pid){
+      // the pass is unchanged, so a queued
+      // process can stay where it is.
+      old = p->tickets;
+      p->tickets = tickets;
+      release(&p->lock);
+      break;
+    }
+    release(&p->lock);
+  }
+  return old;
+}
+
+// The calling process is about to block until process to,
+// whose pid was pid, does something: lend it our tickets
+// so that it gets our share of the CPU meanwhile.  Only
+// stride processes lend, and only to one process at a
+// time.  Undone by reclaimtickets().
+void
+lendtickets(struct proc *to, int pid)
+{
+  struct proc *p = myproc();
+
+  if(p->policy != SCHED_STRIDE || to == 0 || to == p || p->lentto)
+    return;
+  acquire(&to->lock);
+  if(to->pid == pid && to->state != UNUSED && to->state != ZOMBIE){
+    to->borrowed += p->tickets;
+    p->lentto = to;
+    p->lentpid = pid;
+    p->lent = p->tickets;
+  }
+  release(&to->lock);
+}
+
+// Take back the tickets lent by lendtickets(), if any.
+void
+reclaimtickets(void)
+{
+  struct proc *p = myproc();
+  struct proc *to = p->lentto;
+
+  if(to == 0)
+    return;
+  acquire(&to->lock);
+  // to may have exited and its slot been reused.
+  if(to->pid == p->lentpid)
+    to->borrowed -= p->lent;
+  release(&to->lock);
+  p->lentto = 0;
+}
+
+// Allow process pid, or the calling process if pid is 0,
+// to run only on the cpus in mask, bit i for cpu i.
+// Returns the old mask, or -1 if there is no such process
+// or mask has no cpu that has started.
+int
+sched_setaffinity(int mask, int pid)
+{
+  struct proc *p;
+  struct cpu *c;
+  int old = -1, ok = 0, moved = 0;
+
+  mask &= AFFINITY_ALL;
+  for(c = cpus; c < &cpus[NCPU]; c++)
+    if(c->started && (mask & (1 << (c - cpus))))
+      ok = 1;
+  if(!ok)
+    return -1;
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->state != UNUSED && p->pid == pid){
+      old = p->affinity;
+      p->affinity = mask;
+      // runqput() moves a queued process to an allowed
+      // cpu; a running one moves at its next tick, or
+      // now if it is the caller.
+      if(runqremove(p))
+        runqput(p);
+      moved = p == myproc() && (mask & (1 << p->cpu)) == 0;
+      release(&p->lock);
+      break;
+    }
+    release(&p->lock);
+  }
+  if(moved)
+    yield();
+  return old;
+}
+
+// Return the affinity mask of process pid, or the
+// calling process if pid is 0, or -1.
+int
+sched_getaffinity(int pid)
+{
+  struct proc *p;
+  int mask = -1;
+
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->state != UNUSED && p->pid == pid)
+      mask = p->affinity;
+    release(&p->lock);
+    if(mask != -1)
+      break;
+  }
+  return mask;
+}
+
+// Copy the scheduler tunables to user address addr.
+int
+sched_getparams(uint64 addr)
+{
+  return copyout(myproc()->pagetable, addr, (char *)&schedparam, sizeof(schedparam));
+}
+
+// Set the scheduler tunables from user address addr.
+// Returns -1, changing nothing, if any is out of range.
+int
+sched_setparams(uint64 addr)
+{
+  struct schedparam sp;
+
+  if(copyin(myproc()->pagetable, (char *)&sp, addr, sizeof(sp)) < 0)
+    return -1;
+  // a tick must be at least 10000 mtime cycles.
+  if(sp.hz < 1 || sp.hz > 1000 || sp.rrquantum < 1 || sp.agelimit < 1 ||
+     sp.balanceinterval < 1 || sp.cachehot < 0)
+    return -1;
+  for(int i = 0; i < MAXQ; i++)
+    if(sp.mlfqquanta[i] < 1)
+      return -1;
+  // racing readers see a mix of old and new values,
+  // which is harmless.
+  schedparam = sp;
+  settickhz(sp.hz);
+  return 0;
+}
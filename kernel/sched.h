@@ -0,0 +1,43 @@
+// Scheduling policies, for sched_setpolicy().
+#define SCHED_DEFAULT 0  // round robin
+#define SCHED_FCFS    1  // first come first serve
+#define SCHED_PBS     2  // priority based
+#define SCHED_MLFQ    3  // multilevel feedback queue
+#define SCHED_CFS     4  // completely fair, by weighted virtual runtime
+#define SCHED_EDF     5  // real-time, earliest deadline first; see sched_setdeadline()
+#define SCHED_STRIDE  6  // proportional share, by tickets; see settickets()
+#define NSCHED        7
+
+// SCHED_STRIDE tickets, for settickets().
+#define STRIDETICKETS 100    // a new process's tickets
+#define STRIDEMAX     10000  // most tickets one process may hold
+
+// Scheduler tunables, for sched_getparams() and
+// sched_setparams().  Times are in clock ticks.
+struct schedparam {
+  int hz;               // clock ticks per second
+  int rrquantum;        // SCHED_DEFAULT time slice
+  int mlfqquanta[MAXQ]; // SCHED_MLFQ time slice at each level
+  int agelimit;         // SCHED_MLFQ wait before moving up a level
+  int balanceinterval;  // time between load balancing passes
+  int cachehot;         // time after running that a process is cache-hot
+};
+
+// Scheduling latency, from becoming RUNNABLE to being
+// switched in, for sched_getstats().  count[i] is the
+// number of waits of under 2^(i+1) mtime cycles, and of
+// at least 2^i for i > 0.
+#define LATBUCKETS 32
+struct lathist {
+  uint64 count[LATBUCKETS];
+  uint64 n;             // number of waits
+  uint64 max;           // longest wait, in mtime cycles
+};
+
+struct schedstat {
+  struct lathist policy[NSCHED];  // by SCHED_* policy
+  struct lathist mlfq[MAXQ];      // SCHED_MLFQ, by level
+};
+
+// sched_setaffinity() mask allowing every cpu.
+#define AFFINITY_ALL  ((1 << NCPU) - 1)
@@ -0,0 +1,117 @@
+// Scheduler event tracing.
+//
+// Each hart records events in its own ring buffer, with
+// interrupts off, so the only writer of a ring never
+// races with itself and needs no lock.  A writer never
+// waits for the reader: once a ring is full, new events
+// overwrite the oldest unread ones.  schedtrace() drains
+// the rings, merged in time order; readers are serialized
+// by tracelock, and check after copying an event that
+// its writer has not started to overwrite it.
+
+#include "types.h"
+#include "param.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "schedtrace.h"
+#include "defs.h"
+
+#define NTRACE 256              // events per hart
+
+struct tracering {
+  struct schedevent ev[NTRACE];
+  uint head;                    // events written, by its hart only
+  uint tail;                    // events read; tracelock
+};
+
+static struct tracering rings[NCPU];
+static struct spinlock tracelock;
+
+void
+traceinit(void)
+{
+  initlock(&tracelock, "trace");
+}
+
+// Record an event of type about p on this hart.
+void
+traceevent(int type, struct proc *p, int arg)
+{
+  struct tracering *r;
+  struct schedevent *e;
+
+  push_off();
+  r = &rings[cpuid()];
+  e = &r->ev[r->head % NTRACE];
+  e->time = r_time();
+  e->pid = p->pid;
+  e->cpu = cpuid();
+  e->type = type;
+  e->policy = p->policy;
+  e->level = p->PQIndex;
+  e->prio = p->priority;
+  e->arg = arg;
+  // publish the event only once it is complete.
+  __sync_synchronize();
+  r->head++;
+  pop_off();
+}
+
+// Copy the oldest unread event of r to e, skipping any
+// that have been overwritten.  Returns 0 if there is none.
+// Caller must hold tracelock.
+static int
+tracepeek(struct tracering *r, struct schedevent *e)
+{
+  uint head;
+
+  for(;;){
+    head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    if(r->tail == head)
+      return 0;
+    if(head - r->tail > NTRACE)
+      r->tail = head - NTRACE;
+    *e = r->ev[r->tail % NTRACE];
+    __sync_synchronize();
+    // the writer starts on slot tail once head reaches
+    // tail + NTRACE.
+    if(r->head - r->tail < NTRACE)
+      return 1;
+    r->tail++;
+  }
+}
+
+// Copy up to n unread events, oldest first, to the
+// user array at addr.  Returns the number copied, or -1.
+int
+schedtrace(uint64 addr, int n)
+{
+  struct schedevent next[NCPU];
+  int have[NCPU];
+  int i, best, got;
+
+  if(n < 0)
+    return -1;
+  acquire(&tracelock);
+  for(i = 0; i < NCPU; i++)
+    have[i] = tracepeek(&rings[i], &next[i]);
+  for(got = 0; got < n; got++){
+    best = -1;
+    for(i = 0; i < NCPU; i++){
+      if(have[i] && (best < 0 || next[i].time < next[best].time))
+        best = i;
+    }
+    if(best < 0)
+      break;
+    if(copyout(myproc()->pagetable, addr + got * sizeof(struct schedevent),
+               (char *)&next[best], sizeof(struct schedevent)) < 0){
+      release(&tracelock);
+      return -1;
+    }
+    rings[best].tail++;
+    have[best] = tracepeek(&rings[best], &next[best]);
+  }
+  release(&tracelock);
+  return got;
+}
@@ -0,0 +1,24 @@
+// Scheduler trace events, for schedtrace().
+#define SE_SWITCHIN   1  // arg: cpu it last ran on
+#define SE_SWITCHOUT  2  // arg: SR_* reason
+#define SE_WAKEUP     3  // arg: cpu it is queued on
+#define SE_FORK       4  // pid is the child; arg: parent pid
+#define SE_EXIT       5  // arg: exit status
+#define SE_DEMOTE     6  // MLFQ time slice used up; arg: old level
+#define SE_AGE        7  // MLFQ ageing; arg: old level
+
+// SE_SWITCHOUT reasons.
+#define SR_PREEMPT    0  // still RUNNABLE
+#define SR_SLEEP      1
+#define SR_EXIT       2
+
+struct schedevent {
+  uint64 time;      // mtime cycles, MTIME_NS ns each
+  int pid;
+  short cpu;        // hart the event happened on
+  short type;       // SE_*
+  short policy;     // SCHED_* in sched.h
+  short level;      // MLFQ PQIndex
+  int prio;         // PBS dynamic priority
+  int arg;
+};
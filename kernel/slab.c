@@ -0,0 +1,231 @@
+// Slab allocator for fixed-size kernel objects.
+//
+// A cache hands out objects of one type, carved from
+// page-sized slabs.  Each slab starts with a struct slab
+// holding a stack of the indices of its free objects, so
+// free objects are never written to: an object is readied
+// by the cache's constructor once, when its slab is made,
+// and must be freed in that same state, e.g. with its
+// locks released.
+//
+// Each cpu keeps a magazine of up to MAGSIZE free objects
+// per cache, so most allocations and frees only take that
+// cpu's magazine lock.  A cache keeps one empty slab for
+// reuse and gives further ones back to kalloc at once;
+// slabreclaim(), called when kalloc runs out, empties the
+// magazines and gives back every empty slab.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "slab.h"
+#include "defs.h"
+
+struct slab {
+  struct slab *next;          // in its cache's partial or full list
+  struct slab *prev;
+  char *objs;                 // first object
+  int nfree;
+  ushort free[];              // indices of free objects, nfree of them
+};
+
+static struct spinlock slablock;  // protects caches
+static struct slabcache *caches;
+
+static void
+listpush(struct slab **l, struct slab *s)
+{
+  s->prev = 0;
+  s->next = *l;
+  if(s->next)
+    s->next->prev = s;
+  *l = s;
+}
+
+static void
+listremove(struct slab **l, struct slab *s)
+{
+  if(s->prev)
+    s->prev->next = s->next;
+  else
+    *l = s->next;
+  if(s->next)
+    s->next->prev = s->prev;
+}
+
+// Make a cache of objects of size bytes, each readied for
+// use by ctor, if not 0, before it is first allocated.
+void
+slabinit(struct slabcache *c, char *name, uint size, void (*ctor)(void*))
+{
+  static int first = 1;
+
+  if(first){
+    initlock(&slablock, "slab");
+    first = 0;
+  }
+  initlock(&c->lock, name);
+  for(int i = 0; i < NCPU; i++){
+    initlock(&c->mag[i].lock, name);
+    c->mag[i].n = 0;
+  }
+  c->name = name;
+  c->size = (size + 7) & ~7;
+  c->perslab = (PGSIZE - sizeof(struct slab) - 8) / (c->size + sizeof(ushort));
+  if(c->perslab < 1)
+    panic("slabinit");
+  c->ctor = ctor;
+  c->partial = c->full = 0;
+  c->nslab = c->nempty = 0;
+
+  acquire(&slablock);
+  c->next = caches;
+  caches = c;
+  release(&slablock);
+}
+
+// Make a new slab for c.  Returns 0 if out of memory.
+static struct slab*
+slabgrow(struct slabcache *c)
+{
+  struct slab *s;
+  uint64 objs;
+
+  if((s = kalloc()) == 0)
+    return 0;
+  objs = (uint64)s + sizeof(struct slab) + c->perslab * sizeof(ushort);
+  s->objs = (char *)((objs + 7) & ~7);
+  s->nfree = c->perslab;
+  for(int i = 0; i < c->perslab; i++){
+    s->free[i] = c->perslab - 1 - i;
+    if(c->ctor)
+      c->ctor(s->objs + i * c->size);
+  }
+  return s;
+}
+
+// Return obj to its slab, and return 1 if that freed the
+// slab's page.  Caller must hold c->lock.
+static int
+slabput(struct slabcache *c, void *obj)
+{
+  struct slab *s = (struct slab *)PGROUNDDOWN((uint64)obj);
+
+  if(s->nfree == 0){
+    listremove(&c->full, s);
+    listpush(&c->partial, s);
+  }
+  s->free[s->nfree++] = ((char *)obj - s->objs) / c->size;
+  if(s->nfree == c->perslab){
+    if(c->nempty > 0){
+      listremove(&c->partial, s);
+      c->nslab--;
+      kfree(s);
+      return 1;
+    }
+    c->nempty++;
+  }
+  return 0;
+}
+
+// Allocate an object from c.  Returns 0 if out of memory.
+void*
+slaballoc(struct slabcache *c)
+{
+  struct magazine *m;
+  struct slab *s;
+  void *obj = 0;
+
+  push_off();
+  m = &c->mag[cpuid()];
+  acquire(&m->lock);
+  if(m->n > 0)
+    obj = m->obj[--m->n];
+  release(&m->lock);
+  pop_off();
+  if(obj)
+    return obj;
+
+  acquire(&c->lock);
+  if((s = c->partial) == 0){
+    // kalloc() may call slabreclaim(), so c->lock
+    // must not be held.
+    release(&c->lock);
+    if((s = slabgrow(c)) == 0)
+      return 0;
+    acquire(&c->lock);
+    c->nslab++;
+    c->nempty++;
+    listpush(&c->partial, s);
+  }
+  if(s->nfree == c->perslab)
+    c->nempty--;
+  obj = s->objs + s->free[--s->nfree] * c->size;
+  if(s->nfree == 0){
+    listremove(&c->partial, s);
+    listpush(&c->full, s);
+  }
+  release(&c->lock);
+  return obj;
+}
+
+// Free obj, which came from slaballoc(c).
+void
+slabfree(struct slabcache *c, void *obj)
+{
+  struct magazine *m;
+
+  push_off();
+  m = &c->mag[cpuid()];
+  acquire(&m->lock);
+  if(m->n == MAGSIZE){
+    // make room by giving half back.
+    acquire(&c->lock);
+    while(m->n > MAGSIZE / 2)
+      slabput(c, m->obj[--m->n]);
+    release(&c->lock);
+  }
+  m->obj[m->n++] = obj;
+  release(&m->lock);
+  pop_off();
+}
+
+// Give every empty slab of every cache back to kalloc,
+// after emptying the magazines.  Returns the number of
+// pages freed.
+int
+slabreclaim(void)
+{
+  struct slabcache *c;
+  struct magazine *m;
+  struct slab *s, *next;
+  int n = 0;
+
+  acquire(&slablock);
+  for(c = caches; c; c = c->next){
+    for(m = c->mag; m < &c->mag[NCPU]; m++){
+      acquire(&m->lock);
+      acquire(&c->lock);
+      while(m->n > 0)
+        n += slabput(c, m->obj[--m->n]);
+      release(&c->lock);
+      release(&m->lock);
+    }
+    acquire(&c->lock);
+    for(s = c->partial; s; s = next){
+      next = s->next;
+      if(s->nfree == c->perslab){
+        listremove(&c->partial, s);
+        c->nslab--;
+        c->nempty--;
+        kfree(s);
+        n++;
+      }
+    }
+    release(&c->lock);
+  }
+  release(&slablock);
+  return n;
+}
@@ -0,0 +1,24 @@
+// Object caches; see slab.c.
+
+#define MAGSIZE 8             // free objects a cpu keeps per cache
+
+// A cpu's stack of free objects of one cache.
+struct magazine {
+  struct spinlock lock;
+  int n;
+  void *obj[MAGSIZE];
+};
+
+struct slabcache {
+  struct spinlock lock;       // protects the slab lists and counts
+  char *name;
+  uint size;                  // object size in bytes
+  int perslab;                // objects per slab page
+  void (*ctor)(void*);        // readies a new object for use; may be 0
+  struct slab *partial;       // slabs with free objects
+  struct slab *full;          // slabs without
+  int nslab;
+  int nempty;                 // slabs with every object free
+  struct magazine mag[NCPU];  // per-cpu free objects
+  struct slabcache *next;     // list of all caches, for slabreclaim()
+};
@@ -16,6 +16,7 @@ initsleeplock(struct sleeplock *lk, char *name)
   lk->name = name;
   lk->locked = 0;
   lk->pid = 0;
+  lk->wq.head = 0;
 }
 
 void
@@ -23,7 +24,7 @@ acquiresleep(struct sleeplock *lk)
 {
   acquire(&lk->lk);
   while (lk->locked) {
-    sleep(lk, &lk->lk);
+    sleep(&lk->wq, &lk->lk);
   }
   lk->locked = 1;
   lk->pid = myproc()->pid;
@@ -36,7 +37,7 @@ releasesleep(struct sleeplock *lk)
   acquire(&lk->lk);
   lk->locked = 0;
   lk->pid = 0;
-  wakeup(lk);
+  wakeup(&lk->wq);
   release(&lk->lk);
 }
 
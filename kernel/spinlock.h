@@ -7,3 +7,11 @@ struct spinlock {
   struct cpu *cpu;   // The cpu holding the lock.
 };
 
+// Processes sleeping until some condition holds, linked
+// through p->wqnext.  Protected by the spinlock the
+// sleepers pass to sleep(), which wakeup()'s caller
+// must hold as well.
+struct waitq {
+  struct proc *head;
+};
+
@@ -107,6 +107,17 @@ extern uint64 sys_uptime(void);
 extern uint64 sys_trace(void);
 extern uint64 sys_set_priority(void);
 extern uint64 sys_waitx(void);
+extern uint64 sys_sched_setpolicy(void);
+extern uint64 sys_sched_setdeadline(void);
+extern uint64 sys_settickets(void);
+extern uint64 sys_sched_setaffinity(void);
+extern uint64 sys_sched_getaffinity(void);
+extern uint64 sys_getrusage(void);
+extern uint64 sys_sched_getparams(void);
+extern uint64 sys_sched_setparams(void);
+extern uint64 sys_schedtrace(void);
+extern uint64 sys_sched_getstats(void);
+extern uint64 sys_memstat(void);
 
 static uint64 (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -133,6 +144,17 @@ static uint64 (*syscalls[])(void) = {
 [SYS_trace]   sys_trace,
 [SYS_set_priority]   sys_set_priority,
 [SYS_waitx]   sys_waitx,
+[SYS_sched_setpolicy] sys_sched_setpolicy,
+[SYS_sched_setdeadline] sys_sched_setdeadline,
+[SYS_settickets] sys_settickets,
+[SYS_sched_setaffinity] sys_sched_setaffinity,
+[SYS_sched_getaffinity] sys_sched_getaffinity,
+[SYS_getrusage] sys_getrusage,
+[SYS_sched_getparams] sys_sched_getparams,
+[SYS_sched_setparams] sys_sched_setparams,
+[SYS_schedtrace] sys_schedtrace,
+[SYS_sched_getstats] sys_sched_getstats,
+[SYS_memstat] sys_memstat,
 };
 
 struct sysindex{
@@ -165,6 +187,17 @@ struct sysindex sysindex[] =
   [SYS_mkdir] { 1, "mkdir" },
   [SYS_close] { 1, "close" },
   [SYS_trace] { 1, "trace" },
+  [SYS_sched_setpolicy] { 2, "sched_setpolicy" },
+  [SYS_sched_setdeadline] { 4, "sched_setdeadline" },
+  [SYS_settickets] { 2, "settickets" },
+  [SYS_sched_setaffinity] { 2, "sched_setaffinity" },
+  [SYS_sched_getaffinity] { 1, "sched_getaffinity" },
+  [SYS_getrusage] { 2, "getrusage" },
+  [SYS_sched_getparams] { 1, "sched_getparams" },
+  [SYS_sched_setparams] { 1, "sched_setparams" },
+  [SYS_schedtrace] { 2, "schedtrace" },
+  [SYS_sched_getstats] { 2, "sched_getstats" },
+  [SYS_memstat] { 1, "memstat" },
 };
 
 void
@@ -23,3 +23,14 @@
 #define SYS_trace  22
 #define SYS_set_priority 23
 #define SYS_waitx 24
+#define SYS_sched_setpolicy 25
+#define SYS_sched_setdeadline 26
+#define SYS_settickets 27
+#define SYS_sched_setaffinity 28
+#define SYS_sched_getaffinity 29
+#define SYS_getrusage 30
+#define SYS_sched_getparams 31
+#define SYS_sched_setparams 32
+#define SYS_schedtrace 33
+#define SYS_sched_getstats 34
+#define SYS_memstat 35
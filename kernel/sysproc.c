@@ -6,6 +6,8 @@
 #include "memlayout.h"
 #include "spinlock.h"
 #include "proc.h"
+#include "timer.h"
+#include "memstat.h"
 
 uint64
 sys_exit(void)
@@ -41,7 +43,7 @@ sys_wait(void)
 uint64
 sys_waitx(void)
 {
-  uint64 addr, addr1, addr2;
+  uint64 addr, addr1, addr2, addr3;
   int wtime, rtime;
   if(argaddr(0, &addr) < 0)
     return -1;
@@ -49,7 +51,9 @@ sys_waitx(void)
     return -1;
   if(argaddr(2, &addr2) < 0)
     return -1;
-  int ret = waitx(addr, &wtime, &rtime);
+  if(argaddr(3, &addr3) < 0)
+    return -1;
+  int ret = waitx(addr, &wtime, &rtime, addr3);
   struct proc* p = myproc();
   if(copyout(p->pagetable, addr1, (char*)&wtime, sizeof(int)) < 0)
     return -1;
@@ -76,18 +80,22 @@ uint64
 sys_sleep(void)
 {
   int n;
-  uint ticks0;
+  struct timer t;
 
   if(argint(0, &n) < 0)
     return -1;
+  // sleep until the timer fires, rather than
+  // waking up to check on every tick.
+  t.wq.head = 0;
   acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
+  timeradd(&t, ticks + n, timerwake);
+  while(t.pending){
     if(myproc()->killed){
+      timerdel(&t);
       release(&tickslock);
       return -1;
     }
-    sleep(&ticks, &tickslock);
+    sleep(&t.wq, &tickslock);
   }
   release(&tickslock);
   return 0;
@@ -108,12 +116,7 @@ sys_kill(void)
 uint64
 sys_uptime(void)
 {
-  uint xticks;
-
-  acquire(&tickslock);
-  xticks = ticks;
-  release(&tickslock);
-  return xticks;
+  return ticks;
 }
 
 uint64
@@ -138,4 +141,125 @@ sys_set_priority(void)
     return -1;
   set_priority(priority,pid,&old);
   return old;
+}
+
+uint64
+sys_sched_setpolicy(void)
+{
+  int policy;
+  int pid;
+  if(argint(0, &policy) < 0)
+    return -1;
+  if(argint(1, &pid) < 0)
+    return -1;
+  return sched_setpolicy(policy, pid);
+}
+
+uint64
+sys_sched_setdeadline(void)
+{
+  int runtime, period, deadline, pid;
+  if(argint(0, &runtime) < 0)
+    return -1;
+  if(argint(1, &period) < 0)
+    return -1;
+  if(argint(2, &deadline) < 0)
+    return -1;
+  if(argint(3, &pid) < 0)
+    return -1;
+  return sched_setdeadline(runtime, period, deadline, pid);
+}
+
+uint64
+sys_settickets(void)
+{
+  int tickets;
+  int pid;
+  if(argint(0, &tickets) < 0)
+    return -1;
+  if(argint(1, &pid) < 0)
+    return -1;
+  return settickets(tickets, pid);
+}
+
+uint64
+sys_sched_setaffinity(void)
+{
+  int mask;
+  int pid;
+  if(argint(0, &mask) < 0)
+    return -1;
+  if(argint(1, &pid) < 0)
+    return -1;
+  return sched_setaffinity(mask, pid);
+}
+
+uint64
+sys_sched_getaffinity(void)
+{
+  int pid;
+  if(argint(0, &pid) < 0)
+    return -1;
+  return sched_getaffinity(pid);
+}
+
+uint64
+sys_getrusage(void)
+{
+  int pid;
+  uint64 addr;
+  if(argint(0, &pid) < 0)
+    return -1;
+  if(argaddr(1, &addr) < 0)
+    return -1;
+  return getrusage(pid, addr);
+}
+
+uint64
+sys_sched_getparams(void)
+{
+  uint64 addr;
+  if(argaddr(0, &addr) < 0)
+    return -1;
+  return sched_getparams(addr);
+}
+
+uint64
+sys_sched_setparams(void)
+{
+  uint64 addr;
+  if(argaddr(0, &addr) < 0)
+    return -1;
+  return sched_setparams(addr);
+}
+
+uint64
+sys_schedtrace(void)
+{
+  uint64 addr;
+  int n;
+  if(argaddr(0, &addr) < 0 || argint(1, &n) < 0)
+    return -1;
+  return schedtrace(addr, n);
+}
+
+uint64
+sys_sched_getstats(void)
+{
+  uint64 addr;
+  int reset;
+  if(argaddr(0, &addr) < 0 || argint(1, &reset) < 0)
+    return -1;
+  return sched_getstats(addr, reset);
+}
+
+uint64
+sys_memstat(void)
+{
+  uint64 addr;
+  struct memstat ms;
+  if(argaddr(0, &addr) < 0)
+    return -1;
+  kmemstat(&ms);
+  return copyout(myproc()->pagetable, addr, (char *)&ms, sizeof(ms));
 }
\ No newline at end of file
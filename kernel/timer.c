@@ -0,0 +1,151 @@
+// Kernel timeouts.
+//
+// Pending timers are kept in a two-level timer wheel,
+// as in Linux.  tv1 has a slot for each of the next
+// TVSIZE ticks; tv2 has a slot for each of the next
+// TVSIZE runs of TVSIZE ticks, and its slots are emptied
+// into tv1 as their run comes up.  Adding, deleting and
+// firing a timer are O(1), and a clock tick only looks
+// at the timers that are due, plus one tv2 slot every
+// TVSIZE ticks.  Timers further ahead than the wheel
+// reaches wait in the last tv2 slot and are looked at
+// again every TVSIZE*TVSIZE ticks.
+//
+// Everything is protected by tickslock.
+
+#include "types.h"
+#include "param.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "timer.h"
+#include "defs.h"
+
+#define TVBITS 6
+#define TVSIZE (1 << TVBITS)
+#define TVMASK (TVSIZE - 1)
+
+static struct timer *tv1[TVSIZE];
+static struct timer *tv2[TVSIZE];
+static uint wheeltime;          // last tick the wheel has been run for
+
+static void
+link(struct timer **slot, struct timer *t)
+{
+  t->next = *slot;
+  if(t->next)
+    t->next->pprev = &t->next;
+  t->pprev = slot;
+  *slot = t;
+}
+
+static void
+unlink(struct timer *t)
+{
+  *t->pprev = t->next;
+  if(t->next)
+    t->next->pprev = t->pprev;
+}
+
+// Put t in the slot for t->expires, which must be
+// at or after wheeltime.
+static void
+wheeladd(struct timer *t)
+{
+  uint delta = t->expires - wheeltime;
+
+  if(delta < TVSIZE)
+    link(&tv1[t->expires & TVMASK], t);
+  else if(delta < TVSIZE * TVSIZE)
+    link(&tv2[(t->expires >> TVBITS) & TVMASK], t);
+  else
+    link(&tv2[((wheeltime >> TVBITS) - 1) & TVMASK], t);
+}
+
+// Fire t at tick expires, or at once if expires has
+// passed.  Caller must hold tickslock.
+void
+timeradd(struct timer *t, uint expires, void (*fn)(struct timer*))
+{
+  t->expires = expires;
+  t->fn = fn;
+  if((int)(expires - wheeltime) <= 0){
+    t->pending = 0;
+    fn(t);
+    return;
+  }
+  t->pending = 1;
+  wheeladd(t);
+}
+
+// Cancel t if it has not fired yet.
+// Caller must hold tickslock.
+void
+timerdel(struct timer *t)
+{
+  if(t->pending){
+    unlink(t);
+    t->pending = 0;
+  }
+}
+
+// Return the tick at which the next timer may fire, or
+// 0 if none is pending.  Caller must hold tickslock.
+uint
+timernext(void)
+{
+  uint t;
+  int i;
+
+  // the next TVSIZE ticks, and the tv2 slot that
+  // is cascaded among them.
+  for(t = wheeltime + 1; t != wheeltime + TVSIZE + 1; t++){
+    if((t & TVMASK) == 0 && tv2[(t >> TVBITS) & TVMASK])
+      return t;
+    if(tv1[t & TVMASK])
+      return t;
+  }
+  // the other tv2 slots, in the order they are cascaded.
+  t = ((wheeltime + TVSIZE) & ~TVMASK) + TVSIZE;
+  for(i = 0; i < TVSIZE; i++, t += TVSIZE){
+    if(tv2[(t >> TVBITS) & TVMASK])
+      return t;
+  }
+  return 0;
+}
+
+// A timer fn that wakes the processes sleeping on t->wq.
+void
+timerwake(struct timer *t)
+{
+  wakeup(&t->wq);
+}
+
+// Fire the timers that are due, up to the current tick.
+// Called from clockintr() with tickslock held.
+void
+timerrun(void)
+{
+  struct timer *t, *list;
+
+  while(wheeltime != ticks){
+    wheeltime++;
+    if((wheeltime & TVMASK) == 0){
+      // a new run of TVSIZE ticks: spread its tv2 slot
+      // over tv1.
+      list = tv2[(wheeltime >> TVBITS) & TVMASK];
+      tv2[(wheeltime >> TVBITS) & TVMASK] = 0;
+      while((t = list) != 0){
+        list = t->next;
+        wheeladd(t);
+      }
+    }
+    list = tv1[wheeltime & TVMASK];
+    tv1[wheeltime & TVMASK] = 0;
+    while((t = list) != 0){
+      list = t->next;
+      t->pending = 0;
+      t->fn(t);
+    }
+  }
+}
@@ -0,0 +1,12 @@
+// A kernel timeout: fn(t) is called, with tickslock held,
+// on the first clock tick at or after t->expires.
+struct timer {
+  uint expires;                 // ticks at which to fire
+  void (*fn)(struct timer*);    // called when t fires
+  struct waitq wq;              // for fn to wake, e.g. timerwake()
+  int pending;                  // added and not yet fired or deleted?
+
+  // tickslock must be held when using these:
+  struct timer *next;           // next timer in the same wheel slot
+  struct timer **pprev;         // pointer to the pointer to t in its slot
+};
@@ -6,9 +6,20 @@
 #include "proc.h"
 #include "defs.h"
 
+// ticks is only written by hart 0, in clockintr(), and
+// can be read without a lock.  tickslock protects the
+// kernel timers.
 struct spinlock tickslock;
 uint ticks;
 
+extern uint64 timer_scratch[NCPU][7];
+extern uint64 timerinterval;
+extern uint64 tickbase;
+
+// bumped by settickhz(), so that each hart realigns its
+// timer to the new tick grid.
+uint tickgen;
+
 extern char trampoline[], uservec[], userret[];
 
 // in kernelvec.S, calls kerneltrap().
@@ -65,6 +76,11 @@ usertrap(void)
     intr_on();
 
     syscall();
+  } else if(r_scause() == 15 && uvmcow(p->pagetable, r_stval()) == 0){
+    // store to a copy-on-write page, now copied.
+  } else if((r_scause() == 13 || r_scause() == 15) &&
+            uvmlazy(p->pagetable, r_stval(), p->sz) == 0){
+    // first touch of a page sbrk() reserved, now allocated.
   } else if((which_dev = devintr()) != 0){
     // ok
   } else {
@@ -76,25 +92,11 @@ usertrap(void)
   if(p->killed)
     exit(-1);
 
-  // give up the CPU if this is a timer interrupt.
-  #ifdef DEFAULT
-  if(which_dev == 2)
+  // give up the CPU if this is a timer interrupt
+  // and p's scheduling policy says so, or if
+  // resched() has asked for a switch.
+  if((which_dev == 2 && schedyield(p)) || reschedpending())
     yield();
-  #endif
-  #ifdef MLFQ
-  if(which_dev == 2 && myproc() != 0 && myproc()->state == RUNNING)
-  {
-    struct proc* p = myproc();
-    if(p->timeslices <= 0)
-    {
-      if(p->PQIndex != 4)
-      {
-        p->PQIndex++;
-      }     
-      yield();
-    }
-  }
-  #endif
 
   usertrapret();
 }
@@ -165,42 +167,114 @@ kerneltrap()
     panic("kerneltrap");
   }
 
-  // give up the CPU if this is a timer interrupt.
-  #ifdef DEFAULT
-  if(which_dev == 2 && myproc() != 0 && myproc()->state == RUNNING)
+  // give up the CPU if this is a timer interrupt
+  // and the process's scheduling policy says so, or
+  // if resched() has asked for a switch.
+  if(myproc() != 0 && myproc()->state == RUNNING &&
+     ((which_dev == 2 && schedyield(myproc())) || reschedpending()))
     yield();
-  #endif
-
-  #ifdef MLFQ
-  if(which_dev == 2 && myproc() != 0 && myproc()->state == RUNNING)
-  {
-    struct proc* p = myproc();
-    if(p->timeslices <= 0)
-    {
-      if(p->PQIndex != 4)
-      {
-        p->PQIndex++;
-      }     
-      yield();
-    }
-  }
-  #endif
   // the yield() may have caused some traps to occur,
   // so restore trap registers for use by kernelvec.S's sepc instruction.
   w_sepc(sepc);
   w_sstatus(sstatus);
 }
 
+// mtime at which tick t starts.
+static uint64
+tickstart(uint64 t)
+{
+  return tickbase + t * timerinterval;
+}
+
 void
 clockintr()
 {
+  uint64 now = *(uint64*)CLINT_MTIME;
+
+  acquire(&tickslock);
+  // catch up on the ticks hart 0 slept through
+  // in idlewait().
+  while(now >= tickstart(ticks + 1))
+    ticks++;
+  timerrun();
+  release(&tickslock);
+}
+
+// Make the clock tick hz times a second, on each
+// hart from its next timer interrupt on.
+void
+settickhz(int hz)
+{
+  uint64 interval = 1000000000 / MTIME_NS / hz;
+
   acquire(&tickslock);
-  ticks++;
-  setrtime();
-  wakeup(&ticks);
+  // the current tick keeps its start.
+  tickbase = tickstart(ticks) - ticks * interval;
+  timerinterval = interval;
+  for(int i = 0; i < NCPU; i++)
+    timer_scratch[i][4] = interval;
+  tickgen++;
   release(&tickslock);
 }
 
+// Set this hart's next timer interrupt to the start of
+// the next tick, since timervec only adds the interval
+// to the last one, which may lie on an old tick grid.
+static void
+tickalign(void)
+{
+  mycpu()->tickgen = tickgen;
+  __sync_synchronize();
+  *(uint64*)CLINT_MTIMECMP(cpuid()) = tickstart((*(uint64*)CLINT_MTIME - tickbase) / timerinterval + 1);
+}
+
+// Send an inter-processor interrupt to hart.
+void
+ipi(int hart)
+{
+  *(uint32*)CLINT_MSIP(hart) = 1;
+}
+
+// Called by an idle hart, with interrupts off: stop its
+// periodic timer interrupt until tick wake, or for good
+// if wake is 0, wait for an interrupt, and then get back
+// on the tick.  Hart 0 keeps ticks, so it only stops
+// while every other hart is idle too, and no later than
+// the next kernel timer.
+void
+idlewait(uint wake)
+{
+  struct cpu *c = mycpu(), *o;
+  int id = cpuid();
+  uint next;
+
+  c->tickless = 1;
+  __sync_synchronize();
+  if(id == 0){
+    for(o = cpus; o < &cpus[NCPU]; o++){
+      if(o != c && o->started && !o->idle){
+        // keep ticking.
+        c->tickless = 0;
+        asm volatile("wfi");
+        return;
+      }
+    }
+    acquire(&tickslock);
+    next = timernext();
+    release(&tickslock);
+    if(next && (wake == 0 || (int)(next - wake) < 0))
+      wake = next;
+  }
+  *(uint64*)CLINT_MTIMECMP(id) = wake ? tickstart(wake) : ~0ULL;
+
+  asm volatile("wfi");
+
+  c->tickless = 0;
+  tickalign();
+  if(id == 0)
+    clockintr();
+}
+
 // check if it's an external interrupt or software interrupt,
 // and handle it.
 // returns 2 if timer interrupt,
@@ -234,17 +308,29 @@ devintr()
 
     return 1;
   } else if(scause == 0x8000000000000001L){
-    // software interrupt from a machine-mode timer interrupt,
-    // forwarded by timervec in kernelvec.S.
+    // software interrupt from a machine-mode timer interrupt
+    // or IPI, forwarded by timervec in kernelvec.S.
 
-    if(cpuid() == 0){
-      clockintr();
-    }
-    
     // acknowledge the software interrupt by clearing
     // the SSIP bit in sip.
     w_sip(r_sip() & ~2);
 
+    // an IPI only wakes an idle hart to look at
+    // the run queues, or sends a busy one through
+    // the reschedpending() check on trap return.
+    if(__sync_lock_test_and_set(&timer_scratch[cpuid()][5], 0) == 0)
+      return 1;
+
+    // the tick rate changed since this hart's timer was
+    // last aligned.
+    if(mycpu()->tickgen != tickgen)
+      tickalign();
+    if(cpuid() == 0){
+      clockintr();
+    }
+    setrtime();
+    schedclock();
+
     return 2;
   } else {
     return 0;
@@ -44,6 +44,7 @@ struct spinlock uart_tx_lock;
 char uart_tx_buf[UART_TX_BUF_SIZE];
 uint64 uart_tx_w; // write next to uart_tx_buf[uart_tx_w % UART_TX_BUF_SIZE]
 uint64 uart_tx_r; // read next from uart_tx_buf[uart_tx_r % UART_TX_BUF_SIZE]
+struct waitq uart_tx_wq; // uartputc() waiting for space in uart_tx_buf
 
 extern volatile int panicked; // from printf.c
 
@@ -97,7 +98,7 @@ uartputc(int c)
     if(uart_tx_w == uart_tx_r + UART_TX_BUF_SIZE){
       // buffer is full.
       // wait for uartstart() to open up space in the buffer.
-      sleep(&uart_tx_r, &uart_tx_lock);
+      sleep(&uart_tx_wq, &uart_tx_lock);
     } else {
       uart_tx_buf[uart_tx_w % UART_TX_BUF_SIZE] = c;
       uart_tx_w += 1;
@@ -154,7 +155,7 @@ uartstart()
     uart_tx_r += 1;
     
     // maybe uartputc() is waiting for space in the buffer.
-    wakeup(&uart_tx_r);
+    wakeup(&uart_tx_wq);
     
     WriteReg(THR, c);
   }
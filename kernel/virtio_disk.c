@@ -55,6 +55,7 @@ static struct disk {
 
   // our own book-keeping.
   char free[NUM];  // is a descriptor free?
+  struct waitq freeq; // processes waiting for a free descriptor
   uint16 used_idx; // we've looked this far in used[2..NUM].
 
   // track info about in-flight operations,
@@ -166,7 +167,7 @@ free_desc(int i)
   disk.desc[i].flags = 0;
   disk.desc[i].next = 0;
   disk.free[i] = 1;
-  wakeup(&disk.free[0]);
+  wakeup(&disk.freeq);
 }
 
 // free a chain of descriptors.
@@ -217,7 +218,7 @@ virtio_disk_rw(struct buf *b, int write)
     if(alloc3_desc(idx) == 0) {
       break;
     }
-    sleep(&disk.free[0], &disk.vdisk_lock);
+    sleep(&disk.freeq, &disk.vdisk_lock);
   }
 
   // format the three descriptors.
@@ -270,7 +271,7 @@ virtio_disk_rw(struct buf *b, int write)
 
   // Wait for virtio_disk_intr() to say request has finished.
   while(b->disk == 1) {
-    sleep(b, &disk.vdisk_lock);
+    sleep(&b->wq, &disk.vdisk_lock);
   }
 
   disk.info[idx[0]].b = 0;
@@ -306,7 +307,7 @@ virtio_disk_intr()
 
     struct buf *b = disk.info[id].b;
     b->disk = 0;   // disk is done with buf
-    wakeup(b);
+    wakeup(&b->wq);
 
     disk.used_idx += 1;
   }
@@ -0,0 +1,29 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/memstat.h"
+#include "user/user.h"
+
+// memstat: print free physical memory by block size.
+// For each order, frag is the percentage of free memory
+// in blocks too small for an allocation of that order.
+int main(int argc, char *argv[])
+{
+    struct memstat ms;
+    int i, free = 0, above;
+    if(memstat(&ms) < 0)
+    {
+        fprintf(2, "memstat: failed\n");
+        exit(1);
+    }
+    for(i = 0; i < MAXORDER; i++)
+        free += ms.nfree[i] << i;
+    printf("%d pages, %d free, %d in per-cpu caches\n", ms.npage, free + ms.cached, ms.cached);
+    printf("order\tblocks\tfrag\n");
+    above = free;
+    for(i = 0; i < MAXORDER; i++)
+    {
+        printf("%d\t%d\t%d%%\n", i, ms.nfree[i], free ? 100 - above * 100 / free : 0);
+        above -= ms.nfree[i] << i;
+    }
+    exit(0);
+}
@@ -0,0 +1,49 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/stat.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+// schedparam [name value]...: set scheduler tunables,
+// then print them all.
+int main(int argc, char *argv[])
+{
+    struct schedparam sp;
+    int i, *v;
+    if(sched_getparams(&sp) < 0)
+    {
+        fprintf(2, "schedparam: failed\n");
+        exit(1);
+    }
+    for(i = 1; i + 1 < argc; i += 2)
+    {
+        if(strcmp(argv[i], "hz") == 0)
+            v = &sp.hz;
+        else if(strcmp(argv[i], "rr") == 0)
+            v = &sp.rrquantum;
+        else if(strcmp(argv[i], "age") == 0)
+            v = &sp.agelimit;
+        else if(strcmp(argv[i], "balance") == 0)
+            v = &sp.balanceinterval;
+        else if(strcmp(argv[i], "cachehot") == 0)
+            v = &sp.cachehot;
+        else if(strlen(argv[i]) == 5 && memcmp(argv[i], "mlfq", 4) == 0 && argv[i][4] >= '0' && argv[i][4] < '0' + MAXQ)
+            v = &sp.mlfqquanta[argv[i][4] - '0'];
+        else
+        {
+            fprintf(2, "usage: schedparam [hz|rr|mlfq0..mlfq4|age|balance|cachehot value]...\n");
+            exit(1);
+        }
+        *v = atoi(argv[i + 1]);
+    }
+    if(argc > 1 && sched_setparams(&sp) < 0)
+    {
+        fprintf(2, "schedparam: rejected\n");
+        exit(1);
+    }
+    printf("hz %d rr %d mlfq", sp.hz, sp.rrquantum);
+    for(i = 0; i < MAXQ; i++)
+        printf(" %d", sp.mlfqquanta[i]);
+    printf(" age %d balance %d cachehot %d\n", sp.agelimit, sp.balanceinterval, sp.cachehot);
+    exit(0);
+}
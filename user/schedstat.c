@@ -0,0 +1,94 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/stat.h"
+#include "kernel/memlayout.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+char *policies[] = {
+  [SCHED_DEFAULT] "default",
+  [SCHED_FCFS]    "fcfs",
+  [SCHED_PBS]     "pbs",
+  [SCHED_MLFQ]    "mlfq",
+  [SCHED_CFS]     "cfs",
+  [SCHED_EDF]     "edf",
+  [SCHED_STRIDE]  "stride",
+};
+
+static struct schedstat st;
+
+// mtime cycles to microseconds.
+static int
+us(uint64 cycles)
+{
+    return cycles * MTIME_NS / 1000;
+}
+
+// Upper bound, in cycles, of the pct'th percentile wait.
+static uint64
+percentile(struct lathist *h, int pct)
+{
+    uint64 want = (h->n * pct + 99) / 100, seen = 0;
+    int i;
+    for(i = 0; i < LATBUCKETS - 1; i++)
+    {
+        seen += h->count[i];
+        if(seen >= want)
+            break;
+    }
+    uint64 bound = (2ULL << i) - 1;
+    return bound < h->max ? bound : h->max;
+}
+
+static void
+print(char *name, int level, struct lathist *h)
+{
+    if(h->n == 0)
+        return;
+    printf("%s", name);
+    if(level >= 0)
+        printf("%d", level);
+    printf("\t%d\t%d\t%d\t%d\n", (int)h->n, us(percentile(h, 50)), us(percentile(h, 99)), us(h->max));
+}
+
+// schedstat [-r] [command args...]: print scheduling
+// latency percentiles, in microseconds, since boot or
+// the last reset, or of just the command run; -r resets.
+int main(int argc, char *argv[])
+{
+    int i, reset = 0;
+    if(argc > 1 && strcmp(argv[1], "-r") == 0)
+    {
+        reset = 1;
+        argc--;
+        argv++;
+    }
+    if(argc > 1)
+    {
+        sched_getstats(&st, 1);
+        int pid = fork();
+        if(pid < 0)
+        {
+            fprintf(2, "schedstat: fork failed\n");
+            exit(1);
+        }
+        if(pid == 0)
+        {
+            exec(argv[1], argv + 1);
+            fprintf(2, "schedstat: exec %s failed\n", argv[1]);
+            exit(1);
+        }
+        wait(0);
+    }
+    if(sched_getstats(&st, reset) < 0)
+    {
+        fprintf(2, "schedstat: failed\n");
+        exit(1);
+    }
+    printf("policy\tn\tp50\tp99\tmax\n");
+    for(i = 0; i < NSCHED; i++)
+        print(policies[i], -1, &st.policy[i]);
+    for(i = 0; i < MAXQ; i++)
+        print("mlfq", i, &st.mlfq[i]);
+    exit(0);
+}
@@ -0,0 +1,57 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/memlayout.h"
+#include "kernel/schedtrace.h"
+#include "user/user.h"
+
+static char *types[] = {
+    [SE_SWITCHIN] "in", [SE_SWITCHOUT] "out", [SE_WAKEUP] "wakeup", [SE_FORK] "fork",
+    [SE_EXIT] "exit", [SE_DEMOTE] "demote", [SE_AGE] "age",
+};
+static char *reasons[] = { [SR_PREEMPT] "preempt", [SR_SLEEP] "sleep", [SR_EXIT] "exit" };
+
+static struct schedevent ev[64];
+
+// schedtrace [command args...]: print the scheduler events
+// recorded so far, or run command and print the events
+// recorded while it ran, one per line:
+// us cpu pid event policy level prio arg
+int main(int argc, char *argv[])
+{
+    int n, i;
+    uint64 t0 = 0;
+    if(argc > 1)
+    {
+        while(schedtrace(ev, sizeof(ev) / sizeof(ev[0])) > 0)
+            ;
+        int pid = fork();
+        if(pid < 0)
+        {
+            fprintf(2, "schedtrace: fork failed\n");
+            exit(1);
+        }
+        if(pid == 0)
+        {
+            exec(argv[1], argv + 1);
+            fprintf(2, "schedtrace: exec %s failed\n", argv[1]);
+            exit(1);
+        }
+        wait(0);
+    }
+    while((n = schedtrace(ev, sizeof(ev) / sizeof(ev[0]))) > 0)
+    {
+        for(i = 0; i < n; i++)
+        {
+            struct schedevent *e = &ev[i];
+            if(t0 == 0)
+                t0 = e->time;
+            printf("%d %d %d %s %d %d %d ", (int)((e->time - t0) * MTIME_NS / 1000), e->cpu, e->pid,
+                   types[e->type], e->policy, e->level, e->prio);
+            if(e->type == SE_SWITCHOUT)
+                printf("%s\n", reasons[e->arg]);
+            else
+                printf("%d\n", e->arg);
+        }
+    }
+    exit(0);
+}
@@ -2,20 +2,27 @@
 #include "kernel/stat.h"
 #include "user/user.h"
 #include "kernel/fcntl.h"
+#include "kernel/rusage.h"
 
 
 #define NFORK 10
 #define IO 5
 
-int main() {
+// schedulertest [ncpu]: with ncpu, child n is pinned to cpu n % ncpu.
+int main(int argc, char *argv[]) {
   int n, pid;
   int wtime, rtime;
   int twtime=0, trtime=0;
+  struct rusage ru;
+  uint64 tru=0, twu=0;
+  int ncpu = argc > 1 ? atoi(argv[1]) : 0;
   for(n=0; n < NFORK;n++) {
       pid = fork();
       if (pid < 0)
           break;
       if (pid == 0) {
+          if (ncpu > 0)
+            sched_setaffinity(1 << (n % ncpu), 0);
 #ifndef FCFS
           if (n < IO) {
             sleep(200); // IO bound processes
@@ -34,11 +41,14 @@ int main() {
       }
   }
   for(;n > 0; n--) {
-      if(waitx(0,&rtime,&wtime) >= 0) {
+      if(waitx(0,&rtime,&wtime,&ru) >= 0) {
           trtime += rtime;
           twtime += wtime;
+          tru += ru.rtime;
+          twu += ru.wtime;
       } 
   }
   printf("Average rtime %d,  wtime %d\n", trtime / NFORK, twtime / NFORK);
+  printf("Average run %d us,  wait %d us\n", (int)(tru / NFORK / 1000), (int)(twu / NFORK / 1000));
   exit(0);
 }
@@ -0,0 +1,24 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+int main(int argc, char *argv[])
+{
+    int runtime, period, deadline, pid;
+    if(argc < 5)
+    {
+        fprintf(2, "usage: setdeadline runtime period deadline pid\n");
+        exit(1);
+    }
+    runtime = atoi(argv[1]);
+    period = atoi(argv[2]);
+    deadline = atoi(argv[3]);
+    pid = atoi(argv[4]);
+    // a runtime of 0 returns pid to the system's policy.
+    if(sched_setdeadline(runtime, period, deadline, pid) < 0)
+    {
+        fprintf(2, "setdeadline: rejected\n");
+        exit(1);
+    }
+    exit(0);
+}
@@ -0,0 +1,45 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/stat.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+char *policies[] = {
+  [SCHED_DEFAULT] "default",
+  [SCHED_FCFS]    "fcfs",
+  [SCHED_PBS]     "pbs",
+  [SCHED_MLFQ]    "mlfq",
+  [SCHED_CFS]     "cfs",
+  [SCHED_EDF]     "edf",
+  [SCHED_STRIDE]  "stride",
+};
+
+int main(int argc, char *argv[])
+{
+    int policy, pid, old;
+    if(argc < 2)
+    {
+        fprintf(2, "usage: setpolicy default|fcfs|pbs|mlfq|cfs|stride [pid]\n");
+        exit(1);
+    }
+    for(policy = 0; policy < NSCHED; policy++)
+    {
+        if(strcmp(argv[1], policies[policy]) == 0)
+            break;
+    }
+    if(policy == NSCHED)
+    {
+        fprintf(2, "setpolicy: unknown policy %s\n", argv[1]);
+        exit(1);
+    }
+    // with no pid, switch the whole system.
+    pid = argc > 2 ? atoi(argv[2]) : 0;
+    old = sched_setpolicy(policy, pid);
+    if(old < 0)
+    {
+        fprintf(2, "setpolicy: failed\n");
+        exit(1);
+    }
+    printf("%s -> %s\n", policies[old], argv[1]);
+    exit(0);
+}
@@ -0,0 +1,23 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+int main(int argc, char *argv[])
+{
+    int tickets, pid, old;
+    if(argc < 3)
+    {
+        fprintf(2, "usage: settickets tickets pid\n");
+        exit(1);
+    }
+    tickets = atoi(argv[1]);
+    pid = atoi(argv[2]);
+    old = settickets(tickets, pid);
+    if(old < 0)
+    {
+        fprintf(2, "settickets: failed\n");
+        exit(1);
+    }
+    printf("%d -> %d\n", old, tickets);
+    exit(0);
+}
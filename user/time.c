@@ -1,16 +1,31 @@
 #include "kernel/types.h"
 #include "kernel/stat.h"
 #include "kernel/fcntl.h"
+#include "kernel/rusage.h"
 #include "user/user.h"
 
+// time [-c cpumask] [command args...]
 int main(int argc, char *argv[])
 {
+    int mask = 0;
+    if(argc > 2 && strcmp(argv[1], "-c") == 0)
+    {
+        // pin the command to the cpus in cpumask.
+        mask = atoi(argv[2]);
+        argc -= 2;
+        argv += 2;
+    }
     int pid = fork();
     if(pid < 0) {
         printf("fork error\n");
         exit(1);
     }
     else if (pid == 0) {
+        if(mask && sched_setaffinity(mask, 0) < 0)
+        {
+            printf("bad cpumask\n");
+            exit(1);
+        }
         if(argc == 1)
         {
             sleep(10);
@@ -25,8 +40,12 @@ int main(int argc, char *argv[])
     }
     else {
         int rtime, wtime;
-        waitx(0,&rtime, &wtime);
+        struct rusage ru;
+        waitx(0,&rtime, &wtime, &ru);
         printf("rtime: %d, wtime: %d\n", rtime, wtime);
+        printf("run %d us, wait %d us, sleep %d us, elapsed %d us, %d runs, %d voluntary, %d preempted\n",
+               (int)(ru.rtime / 1000), (int)(ru.wtime / 1000), (int)(ru.stime / 1000),
+               (int)(ru.etime / 1000), ru.nrun, ru.nvcsw, ru.nivcsw);
     }
     exit(0);
 }
\ No newline at end of file
@@ -1,11 +1,16 @@
 struct stat;
 struct rtcdate;
+struct rusage;
+struct schedparam;
+struct schedevent;
+struct schedstat;
+struct memstat;
 
 // system calls
 int fork(void);
 int exit(int) __attribute__((noreturn));
 int wait(int*);
-int waitx(int*, int*, int*);
+int waitx(int*, int*, int*, struct rusage*);
 int pipe(int*);
 int write(int, const void*, int);
 int read(int, void*, int);
@@ -26,6 +31,17 @@ int sleep(int);
 int uptime(void);
 void trace(int mask);
 int set_priority(int priority, int pid);
+int sched_setpolicy(int policy, int pid);
+int sched_setdeadline(int runtime, int period, int deadline, int pid);
+int settickets(int tickets, int pid);
+int sched_setaffinity(int mask, int pid);
+int sched_getaffinity(int pid);
+int getrusage(int pid, struct rusage*);
+int sched_getparams(struct schedparam*);
+int sched_setparams(struct schedparam*);
+int schedtrace(struct schedevent*, int);
+int sched_getstats(struct schedstat*, int);
+int memstat(struct memstat*);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -38,4 +38,15 @@ entry("sleep");
 entry("uptime");
 entry("trace");
 entry("set_priority");
-entry("waitx");
\ No newline at end of file
+entry("waitx");
+entry("sched_setpolicy");
+entry("sched_setdeadline");
+entry("settickets");
+entry("sched_setaffinity");
+entry("sched_getaffinity");
+entry("getrusage");
+entry("sched_getparams");
+entry("sched_setparams");
+entry("schedtrace");
+entry("sched_getstats");
+entry("memstat");
\ No newline at end of file